@@ -13,7 +13,8 @@
 
 void setup()
 {
-#if defined(DEBUG) || defined(DEBUG_TOUCH) || defined(TOUCH_CALIBRATION_PROCESS)
+#if defined(DEBUG) || defined(DEBUG_TOUCH) || defined(TOUCH_CALIBRATION_PROCESS) || defined(RENDER_TIMING) \
+    || defined(BUS_STATS) || defined(BUS_HEATMAP)
     Serial.begin(115200);
     while(!Serial) {
         delay(10);
@@ -6,7 +6,7 @@ namespace display
 Arduino_ILI9341& tft_c::instance()
 {
     /// @brief Global scope instances of the tft data bus
-    static Arduino_DataBus *bus = new Arduino_UNOPAR8();
+    static Arduino_DataBus *bus = bus_stats::wrap(new Arduino_UNOPAR8());
     
     /// @brief Global scope instances of the tft display
     static Arduino_ILI9341 *tft = new Arduino_ILI9341(bus, TFT_RST, ORIENTATION, false /* ips */);
@@ -14,6 +14,19 @@ Arduino_ILI9341& tft_c::instance()
     return *tft;
 }
 
+static panel_device_c device_panel;
+static panel_abstract_c *current_panel = &device_panel;
+
+panel_abstract_c &panel()
+{
+    return *current_panel;
+}
+
+void usePanel(panel_abstract_c *panel)
+{
+    current_panel = (panel != nullptr) ? panel : &device_panel;
+}
+
 void initialiseTFT()
 {
    tft_c::instance().begin();
@@ -21,6 +34,16 @@ void initialiseTFT()
    tft_c::instance().fillScreen(RICH_BLACK);
 }
 
+/// @brief Get one column of a character of the default 5x7 font, the glcdfont table Arduino_GFX draws text with
+/// @param c The character
+/// @param col The column, 0 to 4
+/// @return uint8_t: The column's pixels, least significant bit at the top
+static uint8_t glyphColumn(uint8_t c, uint8_t col)
+{
+    if (c >= 176) c++; // the library's default, not quite CP437, mapping
+    return pgm_read_byte(&font[c * 5 + col]);
+}
+
 void drawTextInCanvas(
     int16_t x, 
     int16_t y, 
@@ -31,95 +54,67 @@ void drawTextInCanvas(
     uint8_t textSize
 ) 
 {
-    // Set text properties
-    display::tft_c::instance().setTextColor(textColor);
-    display::tft_c::instance().setTextSize(textSize);
-
-    // Calculate the maximum number of characters per line
-    int16_t charWidth = 6 * textSize; // Default character width in GFX library
-    int16_t charHeight = 8 * textSize; // Default character height in GFX library
-    int16_t maxCharsPerLine = width / charWidth;
-
-    // Split the text into lines, wrapping only between words
-    String wrappedText = "";
-    String currentLine = "";
-    String word = "";
-    const char *ptr = text;
-
-    while (*ptr) {
-        if (*ptr == ' ' || *ptr == '\n') {
-            // Add the current word to the line if it fits
-            if (currentLine.length() + word.length() <= maxCharsPerLine) {
-                currentLine += word + " ";
-            } else {
-                // Wrap the line
-                wrappedText += currentLine + "\n";
-                currentLine = word + " ";
-            }
-            word = ""; // Reset the word
-            if (*ptr == '\n') {
-                wrappedText += currentLine + "\n";
-                currentLine = "";
-            }
-        } else {
-            word += *ptr; // Build the current word
-        }
-        ptr++;
+    text_layout::layout_t layout;
+    {
+        render_timing::scope_c timer(render_timing::stage_t::TEXT);
+        text_layout::wrap(text, width, textSize, &layout);
     }
+    drawTextLayout(x, y, width, height, text, layout, textColor);
+}
 
-    // Add the last word and line
-    if (word.length() > 0) {
-        if (currentLine.length() + word.length() <= maxCharsPerLine) {
-            currentLine += word;
-        } else {
-            wrappedText += currentLine + "\n";
-            currentLine = word;
-        }
-    }
-    if (currentLine.length() > 0) {
-        wrappedText += currentLine;
-    }
+void drawTextLayout(
+    int16_t x,
+    int16_t y,
+    int16_t width,
+    int16_t height,
+    const char *text,
+    text_layout::layout_t const &layout,
+    uint16_t textColor
+)
+{
+    render_timing::scope_c timer(render_timing::stage_t::TEXT);
+    uint8_t const size = layout.text_size;
+    int16_t const charWidth = text_layout::FONT_WIDTH * size;
+    int16_t const charHeight = text_layout::FONT_HEIGHT * size;
 
-    // Calculate the total height of the wrapped text
-    int16_t totalLines = 0;
-    for (int i = 0; i < wrappedText.length(); i++) {
-        if (wrappedText[i] == '\n') {
-            totalLines++;
-        }
-    }
-    totalLines++; // Account for the last line
-    int16_t totalTextHeight = totalLines * charHeight;
-
-    // Calculate the starting y-coordinate to center the text
-    int16_t startY = y + (height - totalTextHeight) / 2;
-
-    // Draw the text line by line
-    int16_t currentY = startY;
-    String line = "";
-    for (int i = 0; i < wrappedText.length(); i++) {
-        if (wrappedText[i] == '\n') {
-            // Center the line horizontally
-            int16_t lineWidth = line.length() * charWidth;
-            int16_t startX = x + (width - lineWidth) / 2;
-            display::tft_c::instance().setCursor(startX, currentY);
-            display::tft_c::instance().print(line);
-            line = "";
-            currentY += charHeight;
-        } else {
-            line += wrappedText[i];
+    // Centre the block of lines vertically, and each line horizontally
+    int16_t currentY = y + (height - layout.count * charHeight) / 2;
+    for (uint8_t i = 0; i < layout.count; i++)
+    {
+        text_layout::line_t const &line = layout.lines[i];
+        int16_t left = x + (width - line.length * charWidth) / 2;
+        for (uint8_t c = 0; c < line.length; c++, left += charWidth)
+        {
+            // Each run of set pixels down a glyph column is one rectangle, where the library fills every pixel
+            for (uint8_t font_col = 0; font_col < 5; font_col++)
+            {
+                uint8_t bits = glyphColumn(text[line.start + c], font_col);
+                for (uint8_t font_row = 0; bits != 0; font_row++, bits >>= 1)
+                {
+                    if (!(bits & 1)) continue;
+
+                    uint8_t run = 0;
+                    while (bits & 1)
+                    {
+                        run++;
+                        bits >>= 1;
+                    }
+                    panel().fillRect(left + font_col * size, currentY + font_row * size, size, run * size, textColor);
+                    font_row += run;
+                }
+            }
         }
-    }
-    // Draw the last line
-    if (line.length() > 0) {
-        int16_t lineWidth = line.length() * charWidth;
-        int16_t startX = x + (width - lineWidth) / 2;
-        display::tft_c::instance().setCursor(startX, currentY);
-        display::tft_c::instance().print(line);
+        currentY += charHeight;
     }
 }
 
+/// @brief The library draws the message straight on the display, not through panel(), so a snapshot being recorded
+/// would miss it
+static void abandonSnapshot();
+
 void displayError(char const *msg)
 {
+   abandonSnapshot();
    tft_c::instance().fillScreen(RICH_BLACK);
    tft_c::instance().setTextColor(ANTI_FLASH_WHITE);
    tft_c::instance().setCursor(0, 0);
@@ -129,6 +124,7 @@ void displayError(char const *msg)
 
 void displayMessage(char const *msg)
 {
+   abandonSnapshot();
    tft_c::instance().fillScreen(RICH_BLACK);
    tft_c::instance().setTextColor(ANTI_FLASH_WHITE);
    tft_c::instance().setCursor(0, 0);
@@ -157,6 +153,159 @@ uint8_t textPixelHeight(uint8_t const text_size)
     }
 }
 
+/// @brief Open a file on the SD card, timed as render_timing::stage_t::SD_OPEN
+static File openFile(String const &path, uint8_t mode = FILE_READ)
+{
+    render_timing::scope_c timer(render_timing::stage_t::SD_OPEN);
+    return SD.open(path, mode);
+}
+
+#if BG_CACHE_BYTES > 0
+/// @brief Background regions restored often enough to keep in RAM
+static background_cache_c bg_cache;
+#endif
+
+/// @brief While a background region is being added to the cache, the pixels sent for it are also copied here, in
+/// wire order
+static uint16_t *capture = nullptr;
+static uint32_t capture_left = 0;
+
+/// @brief Copy pixels being sent to the display into the capture buffer, if there is one
+/// @param pixels The pixels in wire order, or nullptr to copy a single repeated colour
+/// @param colour The repeated colour in wire order, when pixels is nullptr
+/// @param len The number of pixels
+static void capturePixels(uint16_t const *pixels, uint16_t colour, uint32_t len)
+{
+    if (capture == nullptr) return;
+
+    if (len > capture_left) len = capture_left;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        *capture++ = pixels ? pixels[i] : colour;
+    }
+    capture_left -= len;
+}
+
+/// @brief Send pixels already in wire order (most significant byte first) to the open address window
+/// @note The bytes go straight to the bus, no pixel is swapped on the way out
+static void sendPixels(uint16_t *pixels, uint32_t len)
+{
+    panel().writeBytes(reinterpret_cast<uint8_t *>(pixels), len * sizeof(uint16_t));
+    capturePixels(pixels, 0, len);
+}
+
+/// @brief Send one colour repeated to the open address window
+/// @param colour The colour in native order
+static void sendRepeat(uint16_t colour, uint32_t len)
+{
+    panel().writeRepeat(colour, len);
+    capturePixels(nullptr, rgb565::swap(colour), len);
+}
+
+/// @brief Runs sent as a repeated colour by blitPixels, and the pixel bytes they saved, see takeRunStats
+static uint32_t run_count = 0;
+static uint32_t run_saved_bytes = 0;
+
+/// @brief Send pixels already in wire order to the open address window, runs of RUN_MIN_PIXELS or more are sent as
+/// a single repeated colour and everything else as bulk writes
+static void blitPixels(uint16_t *pixels, uint32_t len)
+{
+    uint32_t sent = 0;
+    uint32_t i = 0;
+    while (i < len)
+    {
+        uint32_t run = 1;
+        while (((i + run) < len) && (pixels[i + run] == pixels[i]))
+        {
+            run++;
+        }
+
+        if (run >= RUN_MIN_PIXELS)
+        {
+            if (i > sent) sendPixels(pixels + sent, i - sent);
+            sendRepeat(rgb565::swap(pixels[i]), run);
+            run_count++;
+            run_saved_bytes += (run - 1) * sizeof(uint16_t);
+            sent = i + run;
+        }
+        i += run;
+    }
+
+    if (len > sent) sendPixels(pixels + sent, len - sent);
+}
+
+/// @brief Draw a button a row at a time. Fill, border and text are composited in a line buffer, so each pixel is
+/// sent once and nothing is cleared on the screen first.
+/// @param text The text that was laid out
+/// @param layout The text's line breaks, nullptr for no text
+/// @note See drawButton for the other parameters. The button must be on the screen, at least 2x2 and at most
+/// MAX_LINE_PIXELS wide. Text is clipped to the button.
+static void renderButton(
+    int16_t x,
+    int16_t y,
+    int16_t w,
+    int16_t h,
+    uint16_t fill_colour,
+    uint16_t text_colour,
+    uint16_t border_colour,
+    char const *text,
+    text_layout::layout_t const *layout
+)
+{
+    static uint16_t line[MAX_LINE_PIXELS];
+    uint16_t const fill = rgb565::swap(fill_colour);
+    uint16_t const ink = rgb565::swap(text_colour);
+    uint16_t const border = rgb565::swap(border_colour);
+
+    uint8_t const size = layout ? layout->text_size : 1;
+    int16_t const char_width = text_layout::FONT_WIDTH * size;
+    int16_t const char_height = text_layout::FONT_HEIGHT * size;
+    int16_t const text_top = layout ? (h - layout->count * char_height) / 2 : 0;
+    int16_t const text_rows = layout ? layout->count * char_height : 0;
+
+    panel().startWrite();
+    panel().writeAddrWindow(x, y, w, h);
+
+    for (int16_t row = 0; row < h; row++)
+    {
+        // Text that doesn't fit is drawn over the border, as the library's calls would
+        uint16_t const inside = ((row == 0) || (row == (h - 1))) ? border : fill;
+        line[0] = border;
+        for (int16_t col = 1; col < (w - 1); col++)
+        {
+            line[col] = inside;
+        }
+        line[w - 1] = border;
+
+        // Glyph pixels of the text line crossing this row, each font pixel is size x size screen pixels
+        int16_t const band = row - text_top;
+        if ((band >= 0) && (band < text_rows))
+        {
+            text_layout::line_t const &text_line = layout->lines[band / char_height];
+            uint8_t const font_bit = 1 << ((band % char_height) / size);
+            int16_t left = (w - text_line.length * char_width) / 2;
+            for (uint8_t c = 0; c < text_line.length; c++, left += char_width)
+            {
+                for (uint8_t font_col = 0; font_col < 5; font_col++)
+                {
+                    if (!(glyphColumn(text[text_line.start + c], font_col) & font_bit)) continue;
+
+                    int16_t const from = left + font_col * size;
+                    for (int16_t col = (from > 0) ? from : 0; (col < (from + size)) && (col < w); col++)
+                    {
+                        line[col] = ink;
+                    }
+                }
+            }
+        }
+
+        // Rows without text go out as a border pixel, a repeated fill and a border pixel
+        blitPixels(line, w);
+    }
+
+    panel().endWrite();
+}
+
 void drawButton(
     int16_t const x, 
     int16_t const y, 
@@ -165,39 +314,628 @@ void drawButton(
     uint16_t fill_colour, 
     uint16_t text_colour, 
     uint16_t border_colour, 
-    String text, 
-    uint8_t text_size
+    String const &text, 
+    uint8_t text_size,
+    text_layout::layout_t *layout
 )
 {
-    tft_c::instance().fillRect(x, y, x_, y_, fill_colour);
-    tft_c::instance().drawRect(x, y, x_, y_, border_colour);
-
-    if (text != "")
+#if defined(DEBUG)
+    unsigned long const start_us = micros();
+#endif
+    text_layout::layout_t local_layout;
+    if (text.length() > 0)
     {   
         uint8_t scaled_font_size = text_size;
         if (text_size == 0) scaled_font_size = calculateTextSize(y_) + 1;
-        tft_c::instance().setTextSize(scaled_font_size);
-        drawTextInCanvas(x, y, x_, y_, text.c_str(), text_colour, scaled_font_size);
+
+        // Only lay the text out again if there is no layout for this size yet
+        if (layout == nullptr) layout = &local_layout;
+        if (!layout->valid(x_, scaled_font_size))
+        {
+            render_timing::scope_c timer(render_timing::stage_t::TEXT);
+            text_layout::wrap(text.c_str(), x_, scaled_font_size, layout);
+        }
+    }
+    else
+    {
+        layout = nullptr;
+    }
+
+    bool const on_screen = (x >= 0) && (y >= 0) && ((x + x_) <= panel().width()) &&
+                           ((y + y_) <= panel().height());
+    if (BUTTON_LINE_BUFFER && on_screen && (x_ >= 2) && (x_ <= MAX_LINE_PIXELS) && (y_ >= 2))
+    {
+        renderButton(x, y, x_, y_, fill_colour, text_colour, border_colour, text.c_str(), layout);
+    }
+    else
+    {
+        panel().fillRect(x, y, x_, y_, fill_colour);
+        panel().drawRect(x, y, x_, y_, border_colour);
+        if (layout) drawTextLayout(x, y, x_, y_, text.c_str(), *layout, text_colour);
+    }
+
+#if defined(DEBUG)
+    // Build with BUTTON_LINE_BUFFER defined as 0 to compare
+    Serial.println("Button " + text + ": " + String(micros() - start_us) + " us");
+#endif
+}
+
+/// @brief The address window while drawing with transparent pixels skipped, see keyedWindow
+struct keyed_window_t
+{
+    int16_t right; ///< Column after the last one of the region being drawn
+    int16_t x; ///< Where the open window puts the next pixel, -1 before a window is opened
+    int16_t y;
+};
+
+/// @brief Make sure the next pixels sent land at x, y. A window to the end of the row is only opened if they
+/// wouldn't, i.e. after transparent pixels were skipped or at the start of a row.
+static void keyedWindow(keyed_window_t *window, int16_t x, int16_t y)
+{
+    if ((x != window->x) || (y != window->y))
+    {
+        panel().writeAddrWindow(x, y, window->right - x, 1);
+        window->x = x;
+        window->y = y;
+    }
+}
+
+/// @brief Send part of a row of wire order pixels, skipping pixels of the colour key
+/// @param window The address window, see keyedWindow
+/// @param x The x coordinate of the first pixel
+/// @param y The y coordinate of the row
+static void blitKeyed(keyed_window_t *window, int16_t x, int16_t y, uint16_t *pixels, uint16_t len)
+{
+    uint16_t const key = rgb565::swap(rgb565::COLOUR_KEY);
+    uint16_t i = 0;
+    while (i < len)
+    {
+        while ((i < len) && (pixels[i] == key))
+        {
+            i++;
+        }
+        uint16_t const start = i;
+        while ((i < len) && (pixels[i] != key))
+        {
+            i++;
+        }
+        if (i == start) break;
+
+        keyedWindow(window, x + start, y);
+        blitPixels(pixels + start, i - start);
+        window->x += i - start;
+    }
+}
+
+/// @brief The address window a BMP is streamed into, see beginBmpStream
+struct bmp_stream_t
+{
+    bool active; ///< Between beginBmpStream and endBmpStream, the transaction is held open
+    bool open; ///< A window is open and x, y are where its next pixel lands
+    int16_t left; ///< Columns of the open window
+    int16_t right;
+    int16_t x;
+    int16_t y;
+};
+
+static bmp_stream_t bmp_stream = {};
+
+/// @brief Address windows opened for BMP blocks, see takeBmpWindows
+static uint32_t bmp_windows = 0;
+
+/// @brief Hold one transaction open while a BMP is drawn, so blocks that carry on from the last can be sent
+/// without a new address window. Images are drawn top to bottom (see bmp.h), so a whole opaque image is one window.
+static void beginBmpStream()
+{
+    panel().startWrite();
+    bmp_stream.active = true;
+    bmp_stream.open = false;
+}
+
+/// @brief End the transaction started by beginBmpStream
+static void endBmpStream()
+{
+    bmp_stream.active = false;
+    bmp_stream.open = false;
+    panel().endWrite();
+}
+
+/// @brief Callback function to send to the bmp class draw function
+/// @note See bmp.h for usage, the bitmap is always asked for in wire order
+static void bmpDrawCallback(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h)
+{
+    panel_abstract_c &screen = panel();
+    if ((x < 0) || (y < 0) || ((x + w) > screen.width()) || ((y + h) > screen.height()))
+    {
+        // Let the panel clip lines that are partly off the screen. It ends the transaction when it is done.
+        screen.draw16bitBeRGBBitmap(x, y, bitmap, w, h);
+        capturePixels(bitmap, 0, static_cast<uint32_t>(w) * h);
+        if (bmp_stream.active)
+        {
+            screen.startWrite();
+            bmp_stream.open = false;
+        }
+        return;
+    }
+
+    if (!bmp_stream.active)
+    {
+        // The lines fill the window, so runs can carry on from the end of one line into the next
+        screen.startWrite();
+        screen.writeAddrWindow(x, y, w, h);
+        bmp_windows++;
+        blitPixels(bitmap, static_cast<uint32_t>(w) * h);
+        screen.endWrite();
+        return;
+    }
+
+    // Carry on in the open window if the pixels land where its next pixel would, whole rows of it for a block
+    bool const fits = (h == 1) ? ((x + w) <= bmp_stream.right)
+                               : ((x == bmp_stream.left) && ((x + w) == bmp_stream.right));
+    if (!bmp_stream.open || (x != bmp_stream.x) || (y != bmp_stream.y) || !fits)
+    {
+        // Open to the bottom of the screen, so the blocks below can follow on
+        screen.writeAddrWindow(x, y, w, screen.height() - y);
+        bmp_windows++;
+        bmp_stream.open = true;
+        bmp_stream.left = x;
+        bmp_stream.right = x + w;
+    }
+
+    blitPixels(bitmap, static_cast<uint32_t>(w) * h);
+
+    uint16_t const width = bmp_stream.right - bmp_stream.left;
+    uint32_t const next = (x - bmp_stream.left) + static_cast<uint32_t>(w) * h;
+    bmp_stream.x = bmp_stream.left + (next % width);
+    bmp_stream.y = y + (next / width);
+}
+
+/// @brief Most bitmaps remembered as failing to write a sidecar, see uncacheable
+size_t constexpr UNCACHEABLE_PATHS = 8;
+
+/// @brief Hashes of the paths of bitmaps whose sidecar couldn't be written, e.g. on a full or read-only card. They
+/// are drawn from the source without trying again, rather than creating and deleting an empty sidecar every draw.
+static uint32_t uncacheable_paths[UNCACHEABLE_PATHS] = {};
+static size_t uncacheable_next = 0;
+
+/// @brief Most source keys remembered, see cachedSourceKey
+size_t constexpr SOURCE_KEYS = 8;
+
+/// @brief A source key computed this session
+struct source_key_t
+{
+    uint32_t path_hash; ///< 0 for an empty slot
+    uint32_t size;
+    uint32_t key;
+};
+
+static source_key_t source_keys[SOURCE_KEYS] = {};
+static size_t source_keys_next = 0;
+
+/// @brief Hash a path for uncacheable_paths and source_keys
+/// @return uint32_t: FNV-1a hash of the path, never 0 so empty slots don't match
+static uint32_t pathHash(String const &path)
+{
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < path.length(); i++)
+    {
+        hash = (hash ^ static_cast<uint8_t>(path[i])) * 16777619UL;
+    }
+    return (hash != 0) ? hash : 1;
+}
+
+/// @brief Check if a bitmap has already failed to write its sidecar
+static bool uncacheable(uint32_t const path_hash)
+{
+    for (size_t i = 0; i < UNCACHEABLE_PATHS; i++)
+    {
+        if (uncacheable_paths[i] == path_hash) return true;
+    }
+    return false;
+}
+
+/// @brief Get the source key of a bitmap (see sidecar::sourceKey), sampling the file only the first time
+/// @param image_file The open bitmap file
+/// @param path_hash The hash of its path
+/// @return uint32_t: The key
+/// @note Sampling is a scattered read of the source, the cost sidecars are there to avoid, and it would otherwise be
+/// paid on every draw and background restore. Like the icon pack, the card isn't expected to change while running, a
+/// file of a new size is sampled again but a same-sized edit is only seen after a restart.
+static uint32_t cachedSourceKey(File *image_file, uint32_t const path_hash)
+{
+    uint32_t const size = image_file->size();
+    for (size_t i = 0; i < SOURCE_KEYS; i++)
+    {
+        if ((source_keys[i].path_hash == path_hash) && (source_keys[i].size == size)) return source_keys[i].key;
+    }
+
+    uint32_t const key = sidecar::sourceKey(image_file);
+    source_keys[source_keys_next] = {path_hash, size, key};
+    source_keys_next = (source_keys_next + 1) % SOURCE_KEYS;
+    return key;
+}
+
+/// @brief Draw a BMP, using or (re)building its RGB565 sidecar where possible
+/// @param image_file The open bitmap file
+/// @note See drawImage for the other parameters. The card is only asked for a sidecar when the bitmap could have
+/// one, i.e. 24-bit and drawn without clipping.
+static void drawBmpFile(
+    File *image_file, String const &file_path, int16_t x, int16_t y, int16_t w, int16_t h, int16_t yend,
+    bool transparent)
+{
+    static bmp::BmpClass bmp;
+    bmp.colourKey(transparent);
+
+    uint32_t const path_hash = pathHash(file_path);
+    if (!bmp.sidecarSupported(image_file, w, h) || uncacheable(path_hash))
+    {
+        beginBmpStream();
+        bmp.draw(image_file, bmpDrawCallback, true, x, y, w, h, yend);
+        endBmpStream();
+        return;
+    }
+
+    uint32_t const key = cachedSourceKey(image_file, path_hash);
+    String const sidecar_path = sidecar::pathFor(file_path);
+    File sidecar_file = openFile(sidecar_path);
+    sidecar::header_t header;
+
+    if (sidecar_file && sidecar::readHeader(&sidecar_file, &header, image_file->size(), key))
+    {
+        beginBmpStream();
+        bmp.drawSidecar(&sidecar_file, header, bmpDrawCallback, true, x, y, w, h, yend);
+        endBmpStream();
+        sidecar_file.close();
+        return;
+    }
+
+    if (sidecar_file) sidecar_file.close();
+
+    // Only a full draw can (re)build the sidecar, partial draws just decode the source
+    File *tee = nullptr;
+    if (yend == h)
+    {
+        SD.remove(sidecar_path);
+        sidecar_file = openFile(sidecar_path, FILE_WRITE);
+        if (sidecar_file) tee = &sidecar_file;
+    }
+
+    beginBmpStream();
+    bmp.draw(image_file, bmpDrawCallback, true, x, y, w, h, yend, tee, key);
+    endBmpStream();
+
+    if ((yend != h) || (tee && (sidecar_file.size() > 0)))
+    {
+        if (tee) sidecar_file.close();
+        return;
+    }
+
+    // The sidecar couldn't be created or written, don't try again for this bitmap
+    if (tee) sidecar_file.close();
+    SD.remove(sidecar_path);
+    uncacheable_paths[uncacheable_next] = path_hash;
+    uncacheable_next = (uncacheable_next + 1) % UNCACHEABLE_PATHS;
+}
+
+/// @brief Stream part of an RLE image (see rle.h) to the display, runs are sent as a single repeated colour
+/// @param image_file The open RLE file
+/// @param base Where the image starts in the file, non-zero for an icon in the icon pack
+/// @param header The image's header
+/// @param x The x coordinate to draw the region at
+/// @param y The y coordinate to draw the region at
+/// @param src_x The left column of the region in the image
+/// @param src_y The top row of the region in the image
+/// @param w The width of the region
+/// @param h The height of the region
+/// @param transparent If true, pixels of rgb565::COLOUR_KEY are skipped
+/// @note The region is clipped to the image
+static void drawRleRegion(
+    File *image_file,
+    uint32_t base,
+    rle::header_t const &header,
+    int16_t x,
+    int16_t y,
+    int16_t src_x,
+    int16_t src_y,
+    int16_t w,
+    int16_t h,
+    bool transparent
+)
+{
+    int16_t const col_end = ((src_x + w) < header.width) ? (src_x + w) : header.width;
+    int16_t const row_end = ((src_y + h) < header.height) ? (src_y + h) : header.height;
+    if ((src_x < 0) || (src_y < 0) || (src_x >= col_end) || (src_y >= row_end)) return;
+
+    image_file->seek(rle::rowOffset(image_file, src_y, base));
+    sd::buffered_reader_c reader(image_file);
+    uint16_t literal[rle::MAX_PACKET_PIXELS];
+    keyed_window_t window = {static_cast<int16_t>(x + col_end - src_x), -1, -1};
+
+    panel().startWrite();
+    if (!transparent) panel().writeAddrWindow(x, y, col_end - src_x, row_end - src_y);
+
+    bool truncated = false;
+    for (int16_t row = src_y; (row < row_end) && !truncated; row++)
+    {
+        uint16_t col = 0;
+        while (col < header.width)
+        {
+            int const control = reader.read();
+            if (control < 0)
+            {
+                truncated = true;
+                break;
+            }
+
+            // Packets are decoded in full, only the part inside the region is sent
+            uint16_t const count = (control & ~rle::RUN_FLAG) + 1;
+            int16_t const from = (col > src_x) ? col : src_x;
+            int16_t const to = ((col + count) < col_end) ? (col + count) : col_end;
+            uint16_t const visible = (to > from) ? (to - from) : 0;
+            int16_t const dst_x = x + from - src_x;
+            int16_t const dst_y = y + row - src_y;
+
+            if (control & rle::RUN_FLAG)
+            {
+                uint8_t bytes[2] = {0, 0};
+                reader.read(bytes, sizeof(bytes));
+                uint16_t const colour = (bytes[0] << 8) | bytes[1];
+                if (visible && !transparent)
+                {
+                    sendRepeat(colour, visible);
+                }
+                else if (visible && (colour != rgb565::COLOUR_KEY))
+                {
+                    keyedWindow(&window, dst_x, dst_y);
+                    sendRepeat(colour, visible);
+                    window.x += visible;
+                }
+            }
+            else
+            {
+                reader.read(reinterpret_cast<uint8_t *>(literal), count * sizeof(uint16_t));
+                if (visible && !transparent)
+                {
+                    sendPixels(literal + (from - col), visible);
+                }
+                else if (visible)
+                {
+                    blitKeyed(&window, dst_x, dst_y, literal + (from - col), visible);
+                }
+            }
+            col += count;
+        }
     }
+
+    panel().endWrite();
 }
 
-void bmpDrawCallback(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h)
+/// @brief Stream an RLE image (see rle.h) to the display
+/// @param image_file The open RLE file
+/// @param base Where the image starts in the file, non-zero for an icon in the icon pack
+/// @note See drawImage for the other parameters, rows are clipped the same way as for bitmaps
+static void drawRleFile(
+    File *image_file, uint32_t base, int16_t x, int16_t y, int16_t w, int16_t h, int16_t yend, bool transparent)
 {
-    tft_c::instance().draw16bitRGBBitmap(x, y, bitmap, w, h);
+    rle::header_t header;
+    if (!rle::readHeader(image_file, &header, base)) return;
+
+    int16_t const height = header.height;
+    if ((yend <= 0) || (yend > height))
+    {
+        yend = height;
+    }
+
+    // yend keeps the bottom rows of the image, h crops rows that would be below the screen
+    int16_t const first_row = height - yend;
+    int16_t const last_row = (height > h) ? h : height;
+    if (first_row >= last_row) return;
+
+    drawRleRegion(image_file, base, header, x, y + first_row, 0, first_row, w, last_row - first_row, transparent);
 }
 
-void drawBmp(
+/// @brief Stream part of an image stored as raw RGB565 pixels (see icon_pack.h and sidecar.h) to the display
+/// @param image_file The open file
+/// @param base Where the pixels start in the file
+/// @param width The width of the image in pixels
+/// @param height The height of the image in pixels
+/// @note Rows are stored top-down. See drawRleRegion for the other parameters, transparent regions are sent a row at a time
+static void drawRaw565Region(
+    File *image_file,
+    uint32_t base,
+    uint16_t width,
+    uint16_t height,
+    int16_t x,
+    int16_t y,
+    int16_t src_x,
+    int16_t src_y,
+    int16_t w,
+    int16_t h,
+    bool transparent
+)
+{
+    int16_t const col_end = ((src_x + w) < width) ? (src_x + w) : width;
+    int16_t const row_end = ((src_y + h) < height) ? (src_y + h) : height;
+    if ((src_x < 0) || (src_y < 0) || (src_x >= col_end) || (src_y >= row_end)) return;
+
+    uint16_t pixels[RAW_CHUNK_PIXELS];
+    keyed_window_t window = {static_cast<int16_t>(x + col_end - src_x), -1, -1};
+
+    panel().startWrite();
+    if (!transparent) panel().writeAddrWindow(x, y, col_end - src_x, row_end - src_y);
+
+    if ((src_x == 0) && (col_end == width) && !transparent)
+    {
+        // Whole rows are contiguous in the file, so read across row ends
+        image_file->seek(base + static_cast<uint32_t>(src_y) * width * sizeof(uint16_t));
+        uint32_t remaining = static_cast<uint32_t>(width) * (row_end - src_y);
+        while (remaining > 0)
+        {
+            uint16_t const count = (remaining < RAW_CHUNK_PIXELS) ? remaining : RAW_CHUNK_PIXELS;
+            if (image_file->read(reinterpret_cast<uint8_t *>(pixels), count * sizeof(uint16_t)) !=
+                static_cast<int>(count * sizeof(uint16_t)))
+            {
+                break;
+            }
+            blitPixels(pixels, count);
+            remaining -= count;
+        }
+    }
+    else
+    {
+        for (int16_t row = src_y; row < row_end; row++)
+        {
+            image_file->seek(base + (static_cast<uint32_t>(row) * width + src_x) * sizeof(uint16_t));
+            for (int16_t col = src_x; col < col_end; col += RAW_CHUNK_PIXELS)
+            {
+                uint16_t const count = ((col_end - col) < RAW_CHUNK_PIXELS) ? (col_end - col) : RAW_CHUNK_PIXELS;
+                image_file->read(reinterpret_cast<uint8_t *>(pixels), count * sizeof(uint16_t));
+                if (transparent)
+                {
+                    blitKeyed(&window, x + col - src_x, y + row - src_y, pixels, count);
+                }
+                else
+                {
+                    blitPixels(pixels, count);
+                }
+            }
+        }
+    }
+
+    panel().endWrite();
+}
+
+/// @brief A pack that is opened on first use and then kept open
+struct open_pack_t
+{
+    File file;
+    icon_pack::header_t header;
+    bool checked;
+};
+
+/// @brief Get a pack, opening it the first time
+/// @param path Where the pack is on the card
+/// @param pack The pack's state
+/// @return File*: The pack, or nullptr if there isn't a valid one on the card
+static File *openPack(char const *path, open_pack_t *pack)
+{
+    if (!pack->checked)
+    {
+        // Only look once, the card isn't expected to change while running
+        pack->checked = true;
+        pack->file = SD.open(path);
+        if (pack->file && !icon_pack::readHeader(&pack->file, &pack->header))
+        {
+            pack->file.close();
+        }
+    }
+
+    return pack->file ? &pack->file : nullptr;
+}
+
+/// @brief Get the icon pack, opened on first use and then kept open
+/// @param header The pack's header
+/// @return File*: The pack, or nullptr if there isn't a valid one on the card
+static File *iconPack(icon_pack::header_t **header)
+{
+    static open_pack_t pack = {};
+    *header = &pack.header;
+    return openPack(icon_pack::PATH, &pack);
+}
+
+/// @brief Get the thumbnail pack, see iconPack
+static File *thumbnailPack(icon_pack::header_t **header)
+{
+    static open_pack_t pack = {};
+    *header = &pack.header;
+    return openPack(icon_pack::THUMBNAIL_PATH, &pack);
+}
+
+/// @brief Draw an image from a pack, without its rgb565::COLOUR_KEY pixels if the entry is marked transparent
+/// @param pack The open pack
+/// @param entry The image's directory entry
+/// @note See drawImage for the other parameters
+static void drawPackEntry(File *pack, icon_pack::entry_t const &entry, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    bool const transparent = (entry.flags & icon_pack::FLAG_TRANSPARENT);
+    if (entry.format == static_cast<uint8_t>(icon_pack::format_t::RLE))
+    {
+        drawRleFile(pack, entry.offset, x, y, w, h, h, transparent);
+    }
+    else
+    {
+        drawRaw565Region(pack, entry.offset, entry.width, entry.height, x, y, 0, 0, w, h, transparent);
+    }
+}
+
+bool drawPackedIcon(String const &name, int16_t x, int16_t y, int16_t w, int16_t h, bool border)
+{
+#if defined(DEBUG)
+    unsigned long const start_us = micros();
+#endif
+    icon_pack::header_t *header = nullptr;
+    File *pack = iconPack(&header);
+    if (pack == nullptr) return false;
+
+    icon_pack::entry_t entry;
+    if (!icon_pack::find(pack, header->count, name, &entry)) return false;
+
+    drawPackEntry(pack, entry, x, y, w, h);
+
+    if (border)
+    {
+        panel().drawRect(x, y, w, h, ANTI_FLASH_WHITE);
+    }
+
+#if defined(DEBUG)
+    Serial.println(name + " (pack): " + String(micros() - start_us) + " us");
+#endif
+    return true;
+}
+
+bool thumbnailsAvailable()
+{
+    icon_pack::header_t *header = nullptr;
+    return thumbnailPack(&header) != nullptr;
+}
+
+bool drawThumbnail(String const &name, int16_t x, int16_t y)
+{
+    icon_pack::header_t *header = nullptr;
+    File *pack = thumbnailPack(&header);
+    icon_pack::entry_t entry;
+    if ((pack == nullptr) || !icon_pack::find(pack, header->count, name, &entry)) return false;
+
+    drawPackEntry(pack, entry, x, y, entry.width, entry.height);
+    return true;
+}
+
+bool iconTransparent(String const &name)
+{
+    icon_pack::header_t *header = nullptr;
+    File *pack = iconPack(&header);
+    icon_pack::entry_t entry;
+    if ((pack == nullptr) || !icon_pack::find(pack, header->count, name, &entry)) return false;
+
+    return (entry.flags & icon_pack::FLAG_TRANSPARENT);
+}
+
+void drawImage(
     String const file_path, 
     int16_t x, 
     int16_t y, 
     int16_t w, 
     int16_t h, 
     bool border, 
-    int16_t yend
+    int16_t yend,
+    bool transparent
 )
 {
-    static bmp::BmpClass bmp;
-    File image_file = SD.open(file_path);
+#if defined(DEBUG)
+    unsigned long const start_us = micros();
+#endif
+    render_timing::scope_c timer(render_timing::stage_t::DRAW_IMAGE);
+    File image_file = openFile(file_path);
 
     if(!image_file)
     {
@@ -211,14 +949,275 @@ void drawBmp(
         yend = h; // default to the bottom of the screen
     }
 
-    bmp.draw(&image_file, bmpDrawCallback, false, x, y, w, h, yend);
+    String extension = file_path.substring(file_path.lastIndexOf('.') + 1);
+    extension.toLowerCase();
+
+    if (extension == "rle")
+    {
+        drawRleFile(&image_file, 0, x, y, w, h, yend, transparent);
+    }
+    else
+    {
+        drawBmpFile(&image_file, file_path, x, y, w, h, yend, transparent);
+    }
 
     if (border)
     {
-        tft_c::instance().drawRect(x, y, w, h, ANTI_FLASH_WHITE);
+        panel().drawRect(x, y, w, h, ANTI_FLASH_WHITE);
     }
 
     image_file.close();
+
+#if defined(DEBUG)
+    Serial.println(file_path + ": " + String(micros() - start_us) + " us");
+#endif
+}
+
+/// @brief Decode a region of the background, see restoreBackground
+/// @param image_file The open background image
+/// @note See restoreBackground for the other parameters, the region must already be clipped to the screen
+static void decodeBackgroundRegion(
+    File *image_file, String const &file_path, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    String extension = file_path.substring(file_path.lastIndexOf('.') + 1);
+    extension.toLowerCase();
+
+    if (extension == "rle")
+    {
+        rle::header_t header;
+        if (rle::readHeader(image_file, &header))
+        {
+            drawRleRegion(image_file, 0, header, x, y, x, y, w, h, false);
+        }
+        return;
+    }
+
+    File sidecar_file = openFile(sidecar::pathFor(file_path));
+    sidecar::header_t header;
+    if (sidecar_file && sidecar::readHeader(
+        &sidecar_file, &header, image_file->size(), cachedSourceKey(image_file, pathHash(file_path))))
+    {
+        drawRaw565Region(&sidecar_file
+            , sizeof(sidecar::header_t)
+            , header.width
+            , header.height
+            , x, y, x, y, w, h, false);
+    }
+    else if ((w == panel().width()) && (h == panel().height()))
+    {
+        // A full restore is a normal draw, which also (re)builds the sidecar
+        drawBmpFile(image_file, file_path, 0, 0, w, h, h, false);
+    }
+    else
+    {
+        static bmp::BmpClass bmp; // never keyed, the background is opaque
+        beginBmpStream();
+        bmp.drawRegion(image_file, bmpDrawCallback, true, x, y, x, y, w, h);
+        endBmpStream();
+    }
+
+    if (sidecar_file) sidecar_file.close();
+}
+
+void restoreBackground(String const file_path, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    // Clip to the screen, the background is drawn from the top left corner
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if ((x + w) > panel().width()) w = panel().width() - x;
+    if ((y + h) > panel().height()) h = panel().height() - y;
+    if ((w <= 0) || (h <= 0)) return;
+
+#if BG_CACHE_BYTES > 0
+    static String cached_path;
+    if (file_path != cached_path)
+    {
+        bg_cache.clear();
+        cached_path = file_path;
+    }
+
+    uint16_t *cached = bg_cache.find(x, y, w, h);
+    if (cached)
+    {
+        panel().startWrite();
+        panel().writeAddrWindow(x, y, w, h);
+        panel().writeBytes(reinterpret_cast<uint8_t *>(cached), static_cast<uint32_t>(w) * h * sizeof(uint16_t));
+        panel().endWrite();
+        return;
+    }
+#endif
+
+    File image_file = openFile(file_path);
+    if (!image_file)
+    {
+        panel().fillRect(x, y, w, h, INDIGO_DYE);
+        return;
+    }
+
+#if BG_CACHE_BYTES > 0
+    // Regions restored often enough are copied into the cache as they are sent
+    capture = bg_cache.reserve();
+    capture_left = capture ? static_cast<uint32_t>(w) * h : 0;
+#endif
+
+    decodeBackgroundRegion(&image_file, file_path, x, y, w, h);
+    image_file.close();
+
+#if BG_CACHE_BYTES > 0
+    if (capture) bg_cache.commit(capture_left == 0);
+    capture = nullptr;
+#endif
+}
+
+/// @brief Copies what is drawn into the snapshot file between beginSnapshot and endSnapshot
+static panel_snapshot_c snapshot_panel;
+static File snapshot_file;
+static String snapshot_name;
+static uint32_t snapshot_source_size = 0;
+static uint32_t snapshot_source_key = 0;
+
+static void abandonSnapshot()
+{
+    if (current_panel == &snapshot_panel) snapshot_panel.abandon();
+}
+
+/// @brief Fingerprint everything a snapshot is drawn from: the background (see sidecar::sourceKey), the icon pack and
+/// the caller's key for the rest of the screen
+/// @return bool: False if the background can't be opened
+static bool snapshotKey(String const &background_path, uint32_t const content_key, uint32_t *size, uint32_t *key)
+{
+    File image_file = openFile(background_path);
+    if (!image_file) return false;
+
+    *size = image_file.size();
+    uint32_t const background_key = cachedSourceKey(&image_file, pathHash(background_path));
+    image_file.close();
+
+    icon_pack::header_t *header = nullptr;
+    File *pack = iconPack(&header);
+    uint32_t const pack_key = (pack != nullptr) ? cachedSourceKey(pack, pathHash(icon_pack::PATH)) : 0;
+    uint32_t const keys[3] = {background_key, pack_key, content_key};
+
+    // FNV-1a over the bytes of the three keys
+    uint32_t hash = 2166136261UL;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        for (uint8_t b = 0; b < 4; b++)
+        {
+            hash = (hash ^ ((keys[i] >> (b * 8)) & 0xFF)) * 16777619UL;
+        }
+    }
+    *key = hash;
+    return true;
+}
+
+bool drawSnapshot(String const &snapshot_path, String const &background_path, uint32_t const content_key)
+{
+    render_timing::scope_c timer(render_timing::stage_t::DRAW_IMAGE);
+    uint32_t size, key;
+    if (!snapshotKey(background_path, content_key, &size, &key)) return false;
+
+    File file = openFile(snapshot_path);
+    if (!file) return false;
+
+    sidecar::header_t header;
+    bool const valid = sidecar::readHeader(&file, &header, size, key)
+        && (header.width == panel().width())
+        && (header.height == panel().height())
+        && (header.flags == sidecar::FLAG_WIRE_ORDER);
+    if (valid)
+    {
+        // Whole rows top-down, so this reads the file in order into a single window
+        drawRaw565Region(&file, sizeof(sidecar::header_t), header.width, header.height
+            , 0, 0, 0, 0, header.width, header.height, false);
+    }
+
+    file.close();
+    return valid;
+}
+
+bool beginSnapshot(String const &snapshot_path, String const &background_path, uint32_t const content_key)
+{
+    if (current_panel == &snapshot_panel) return false;
+    if (!snapshotKey(background_path, content_key, &snapshot_source_size, &snapshot_source_key)) return false;
+
+    // Not FILE_WRITE, which appends, as pixels are written wherever they land on the screen
+    SD.remove(snapshot_path);
+    snapshot_file = openFile(snapshot_path, O_READ | O_WRITE | O_CREAT);
+    if (!snapshot_file) return false;
+
+    // A blank header until endSnapshot, so an unfinished snapshot is never drawn. The pixels aren't written ahead:
+    // the whole background drawn first fills the file in order, and anything landing past its end fails the
+    // snapshot (see panel_snapshot_c).
+    sidecar::header_t const blank = {};
+    if (snapshot_file.write(reinterpret_cast<uint8_t const *>(&blank), sizeof(blank)) != sizeof(blank))
+    {
+        snapshot_file.close();
+        SD.remove(snapshot_path);
+        return false;
+    }
+
+    snapshot_name = snapshot_path;
+    snapshot_panel.begin(current_panel, &snapshot_file, sizeof(sidecar::header_t));
+    current_panel = &snapshot_panel;
+    return true;
+}
+
+void endSnapshot(bool complete)
+{
+    if (current_panel != &snapshot_panel) return;
+    current_panel = snapshot_panel.panel();
+
+    complete = complete && !snapshot_panel.failed();
+    if (complete)
+    {
+        snapshot_file.seek(0);
+        sidecar::writeHeader(&snapshot_file
+            , panel().width()
+            , panel().height()
+            , sidecar::FLAG_WIRE_ORDER
+            , snapshot_source_size
+            , snapshot_source_key);
+    }
+    snapshot_file.close();
+
+    if (!complete) SD.remove(snapshot_name);
+}
+
+void backgroundCacheStats(uint32_t *hits, uint32_t *misses, uint32_t *used_bytes)
+{
+#if BG_CACHE_BYTES > 0
+    *hits = bg_cache.hits();
+    *misses = bg_cache.misses();
+    *used_bytes = bg_cache.usedBytes();
+#else
+    *hits = 0;
+    *misses = 0;
+    *used_bytes = 0;
+#endif
+}
+
+void takeRunStats(uint32_t *runs, uint32_t *saved_bytes)
+{
+    *runs = run_count;
+    *saved_bytes = run_saved_bytes;
+    run_count = 0;
+    run_saved_bytes = 0;
+}
+
+uint32_t takeBmpWindows()
+{
+    uint32_t const windows = bmp_windows;
+    bmp_windows = 0;
+    return windows;
 }
 
 } // namespace display
@@ -5,9 +5,17 @@
 #define __ILI9341_DRIVER_H__
 
 #include <Arduino_GFX_Library.h>
+#include "background_cache.h"
 #include "bmp.h"
+#include "bus_stats.h"
 #include "constants.h"
+#include "icon_pack.h"
+#include "panel.h"
+#include "panel_snapshot.h"
+#include "render_timing.h"
+#include "rle.h"
 #include "sd_utils.h"
+#include "text_layout.h"
 
 namespace display
 {
@@ -18,6 +26,22 @@ namespace display
 // Orientation of the display
 uint8_t constexpr ORIENTATION = 3;
 
+// Pixels read from the card per write when streaming raw RGB565 images
+uint16_t constexpr RAW_CHUNK_PIXELS = 160;
+
+// Runs of at least this many identical pixels in a line being blitted are sent as one repeated colour. Shorter runs
+// cost more in call overhead than they save on the bus.
+uint16_t constexpr RUN_MIN_PIXELS = 16;
+
+// Draw buttons a row at a time from a line buffer, so each pixel is sent once. Define as 0 to draw them with the
+// library's fill, rectangle and text calls instead, e.g. to compare the two with DEBUG defined.
+#ifndef BUTTON_LINE_BUFFER
+#define BUTTON_LINE_BUFFER 1
+#endif
+
+// Widest button drawn from the line buffer, wider buttons use the library's calls
+uint16_t constexpr MAX_LINE_PIXELS = 320;
+
 class tft_c
 {
 public:
@@ -29,6 +53,48 @@ private:
     tft_c(tft_c const&); // Private copy constructor
 };
 
+/// @brief The panel backend that draws on the ILI9341, used unless usePanel has been given another
+class panel_device_c : public panel_abstract_c
+{
+public:
+    int16_t width() override { return tft_c::instance().width(); }
+    int16_t height() override { return tft_c::instance().height(); }
+    void startWrite() override { tft_c::instance().startWrite(); }
+    void endWrite() override { tft_c::instance().endWrite(); }
+
+    void writeAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) override
+    {
+        tft_c::instance().writeAddrWindow(x, y, w, h);
+    }
+
+    void writeBytes(uint8_t *data, uint32_t len) override { tft_c::instance().writeBytes(data, len); }
+    void writeRepeat(uint16_t colour, uint32_t len) override { tft_c::instance().writeRepeat(colour, len); }
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) override
+    {
+        tft_c::instance().fillRect(x, y, w, h, colour);
+    }
+
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) override
+    {
+        tft_c::instance().drawRect(x, y, w, h, colour);
+    }
+
+    void draw16bitBeRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h) override
+    {
+        tft_c::instance().draw16bitBeRGBBitmap(x, y, bitmap, w, h);
+    }
+};
+
+/// @brief Get the panel images, backgrounds and buttons are drawn on
+/// @return panel_abstract_c&: The panel given to usePanel, or the ILI9341
+panel_abstract_c &panel();
+
+/// @brief Draw on another panel backend, e.g. a panel_framebuffer_c on a host (see panel_framebuffer.h)
+/// @param panel The panel, or nullptr to go back to the ILI9341. It must outlive its use.
+/// @note Cached backgrounds were sent to the old panel, call this before drawing anything
+void usePanel(panel_abstract_c *panel);
+
 
 /// @brief Initialise the TFT display
 void initialiseTFT();
@@ -51,6 +117,25 @@ void drawTextInCanvas(
     uint8_t textSize = 1
 );
 
+/// @brief Writes text already laid out by text_layout::wrap, centered within a canvas.
+/// @param x The x-coordinate of the top-left corner of the canvas.
+/// @param y The y-coordinate of the top-left corner of the canvas.
+/// @param width The width of the canvas, the same width the text was laid out for.
+/// @param height The height of the canvas.
+/// @param text The text that was laid out.
+/// @param layout The line breaks, drawn at the text size they were made for.
+/// @param textColor The color of the text.
+/// @note Drawn through panel() a rectangle per vertical run of glyph pixels, the same pixels as the library's font.
+void drawTextLayout(
+    int16_t x,
+    int16_t y,
+    int16_t width,
+    int16_t height,
+    const char *text,
+    text_layout::layout_t const &layout,
+    uint16_t textColor
+);
+
 /// @brief Display an error message on the screen
 /// @param msg The message to display
 void displayError(char const *msg);
@@ -78,6 +163,9 @@ uint8_t textPixelHeight(uint8_t const text_size);
 /// @param colour The colour of the button
 /// @param text The text to display on the button, if 0, or not specified, the text will be half the button height
 /// @param text_size The size of the text to display on the button
+/// @param layout Where the text's layout is kept between draws, laid out again only if it doesn't match the size
+/// (default: nullptr, the text is laid out on every draw)
+/// @note With BUTTON_LINE_BUFFER the button is composited a row at a time and every pixel is sent once
 void drawButton(
     int16_t const x, 
     int16_t const y, 
@@ -86,32 +174,111 @@ void drawButton(
     uint16_t fill_colour, 
     uint16_t text_colour, 
     uint16_t border_colour, 
-    String text = "", 
-    uint8_t text_size = 0
+    String const &text = "", 
+    uint8_t text_size = 0,
+    text_layout::layout_t *layout = nullptr
 );
 
-/// @brief Callback function to send to the bmp class draw function
-/// @note See bmp.h for usage
-static void bmpDrawCallback(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h);
-
-/// @brief Draw a bitmap on the screen
-/// @param x The x coordinate of the bitmap
-/// @param y The y coordinate of the bitmap
-/// @param bitmap The bitmap to draw
-/// @param w The width of the bitmap
-/// @param h The height of the bitmap
-/// @param border If true, draw a border around the bitmap (default: false)
-/// @param yend The height to stop drawing at (default: -1, which means the whole image)
-/// @note This function will draw the image from the bottom up, so if using yend, it will stop after drawing yend lines
-void drawBmp(
+/// @brief Draw an image on the screen, either a BMP or an RLE image (see rle.h) chosen by the file extension
+/// @param file_path The path of the image on the SD card
+/// @param x The x coordinate of the image
+/// @param y The y coordinate of the image
+/// @param w The width of the image
+/// @param h The height of the image
+/// @param border If true, draw a border around the image (default: false)
+/// @param yend The number of rows to draw, counted up from the bottom of the image (default: -1, the whole image)
+/// @param transparent If true, pixels of rgb565::COLOUR_KEY are not drawn (default: false)
+/// @note The first full draw of a 24-bit bitmap writes an RGB565 sidecar (see sidecar.h) that is used from then on
+void drawImage(
     String const file_path, 
     int16_t x, 
     int16_t y, 
     int16_t w, 
     int16_t h, 
     bool border = false, 
-    int16_t yend = -1
+    int16_t yend = -1,
+    bool transparent = false
 );
 
+/// @brief Redraw a region of the background image, used to clear where widgets used to be
+/// @param file_path The path of the background image, drawn full screen from the top left corner
+/// @param x The x coordinate of the region
+/// @param y The y coordinate of the region
+/// @param w The width of the region
+/// @param h The height of the region
+/// @note Only the region is read from the card and sent to the display. Regions restored often are kept in RAM
+/// (see background_cache.h) and sent straight from there.
+void restoreBackground(String const file_path, int16_t x, int16_t y, int16_t w, int16_t h);
+
+/// @brief Get the background cache's counters, for tuning BG_CACHE_BYTES
+/// @param hits Restores sent from RAM
+/// @param misses Restores decoded from the SD card
+/// @param used_bytes RAM holding cached regions
+void backgroundCacheStats(uint32_t *hits, uint32_t *misses, uint32_t *used_bytes);
+
+/// @brief Get and reset the count of runs sent as a repeated colour while blitting images
+/// @param runs The number of runs since the last call
+/// @param saved_bytes Pixel bytes the runs didn't send from the buffer since the last call
+void takeRunStats(uint32_t *runs, uint32_t *saved_bytes);
+
+/// @brief Get and reset the count of address windows opened while drawing BMPs and their sidecars
+/// @return uint32_t: The windows opened since the last call, each costs the CASET, PASET and RAMWR commands
+/// @note An opaque image drawn fully on screen takes one window, transparent pixels and clipping take more
+uint32_t takeBmpWindows();
+
+/// @brief Draw a whole screen saved by beginSnapshot and endSnapshot, as one address window read in order
+/// @param snapshot_path The path of the snapshot, e.g. "/home.565"
+/// @param background_path The background the screen was drawn on, a changed background makes the snapshot stale
+/// @param content_key Fingerprint of the rest of the screen, e.g. its buttons' labels and images, as given to
+/// beginSnapshot. A changed icon pack also makes the snapshot stale.
+/// @return bool: False if there is no complete snapshot of the screen's size for these keys, nothing is drawn
+/// @note The contents of loose icon files, drawn when an icon isn't in the pack, aren't part of the key: keying them
+/// would open every icon on each draw, the cost the snapshot saves. Delete the snapshot after editing one.
+bool drawSnapshot(String const &snapshot_path, String const &background_path, uint32_t content_key);
+
+/// @brief Start copying everything drawn through panel() into a snapshot file, see panel_snapshot.h
+/// @param snapshot_path The path of the snapshot, replaced if it exists
+/// @param background_path The background the screen is drawn on, checked by drawSnapshot
+/// @param content_key Fingerprint of the rest of the screen, checked by drawSnapshot
+/// @return bool: False if the file couldn't be created, nothing is copied
+/// @note Every pixel of the screen must be drawn before endSnapshot, the whole background first. Its rows fill the
+/// file in order, a draw that lands past the end of the file so far fails the snapshot.
+/// @note displayMessage and displayError draw around panel(), the snapshot is then not kept
+bool beginSnapshot(String const &snapshot_path, String const &background_path, uint32_t content_key);
+
+/// @brief Stop copying into the snapshot file
+/// @param complete False if the screen wasn't fully drawn, the snapshot is then deleted. It is also deleted if
+/// writing it failed or a message was shown while recording.
+void endSnapshot(bool complete);
+
+/// @brief Draw an icon from the icon pack (see icon_pack.h)
+/// @param name The icon's file name, e.g. "A_FLA039.bmp"
+/// @param x The x coordinate of the icon
+/// @param y The y coordinate of the icon
+/// @param w The width of the icon
+/// @param h The height of the icon
+/// @param border If true, draw a border around the icon (default: false)
+/// @return bool: False if there is no pack or the icon isn't in it, nothing is drawn and the caller should fall back
+/// to drawImage
+/// @note Icons the pack marks as transparent are drawn without their rgb565::COLOUR_KEY pixels
+bool drawPackedIcon(String const &name, int16_t x, int16_t y, int16_t w, int16_t h, bool border = false);
+
+/// @brief Check if there is a thumbnail pack, see icon_pack::THUMBNAIL_PATH
+/// @return bool: False if there isn't a valid one on the card, drawThumbnail then draws nothing
+bool thumbnailsAvailable();
+
+/// @brief Draw an icon's thumbnail from the thumbnail pack, at the size it was made
+/// @param name The icon's file name, e.g. "A_FLA039.bmp"
+/// @param x The x coordinate of the thumbnail
+/// @param y The y coordinate of the thumbnail
+/// @return bool: False if the icon has no thumbnail, nothing is drawn
+/// @note Thumbnails the pack marks as transparent are drawn over whatever is behind them
+bool drawThumbnail(String const &name, int16_t x, int16_t y);
+
+/// @brief Check if an icon has transparent pixels, so whatever is behind it must be drawn first
+/// @param name The icon's file name, e.g. "A_FLA039.bmp"
+/// @return bool: True if the icon pack marks the icon as transparent. Icons not in the pack are drawn opaque.
+bool iconTransparent(String const &name);
+
 } // namespace display
 #endif // __ILI9341_DRIVER_H__
@@ -0,0 +1,243 @@
+/*
+    background_cache.h
+    Description: RAM cache of background regions restored by display::restoreBackground.
+    The same regions are restored again and again as the user moves between screens (the main menu buttons, the
+    macro select rows). Regions restored often enough are kept as RGB565 pixels in RAM, so restoring them again is
+    a single write to the display instead of a decode from the SD card.
+*/
+
+#ifndef __BACKGROUND_CACHE_H__
+#define __BACKGROUND_CACHE_H__
+
+#include <Arduino.h>
+
+/// @brief RAM set aside for cached background pixels, 0 disables the cache
+/// @note Off by default: the UNO R4 has 32 KB of RAM, and the headroom left after the model, the line buffer and the
+/// stack's peak hasn't been measured on every build. With DEBUG defined the free RAM between the heap and the stack
+/// is printed with the cache's hit and miss counts after each restore. Only give the cache what that figure shows is
+/// spare, less a few KB for the stack; 12800 holds one button sized region (80x80 or 106x60).
+#ifndef BG_CACHE_BYTES
+#define BG_CACHE_BYTES 0
+#endif
+
+namespace display
+{
+
+class background_cache_c
+{
+public:
+    /// @brief Number of distinct regions whose restores are counted
+    static size_t constexpr MAX_REGIONS = 16;
+
+    /// @brief Restores of a region needed before it is cached, so one-off restores don't evict useful regions
+    static uint8_t constexpr ADMIT_AFTER = 2;
+
+    /// @brief Size of the cache in pixels
+    static uint32_t constexpr CAPACITY = BG_CACHE_BYTES / sizeof(uint16_t);
+
+    /// @brief Constructor
+    background_cache_c()
+    : m_used(0)
+    , m_pending(MAX_REGIONS)
+    , m_hits(0)
+    , m_misses(0)
+    {
+        for (size_t i = 0; i < MAX_REGIONS; i++)
+        {
+            m_regions[i].count = 0;
+            m_regions[i].cached = false;
+            m_regions[i].width = 0;
+        }
+    }
+
+    /// @brief Count a restore of a region and look it up
+    /// @param x The x coordinate of the region
+    /// @param y The y coordinate of the region
+    /// @param w The width of the region
+    /// @param h The height of the region
+    /// @return uint16_t*: The region's pixels, or nullptr on a miss. See reserve() to add the region after a miss.
+    uint16_t *find(int16_t x, int16_t y, int16_t w, int16_t h)
+    {
+        size_t idx = _lookup(x, y, w, h);
+        if (idx == MAX_REGIONS) idx = _insert(x, y, w, h);
+
+        m_pending = idx;
+        if (idx == MAX_REGIONS)
+        {
+            m_misses++;
+            return nullptr;
+        }
+
+        region_t &region = m_regions[idx];
+        if (region.count == UINT8_MAX) _age();
+        region.count++;
+
+        if (region.cached)
+        {
+            m_hits++;
+            return m_pixels + region.offset;
+        }
+
+        m_misses++;
+        return nullptr;
+    }
+
+    /// @brief Make room for the region of the last miss, if it is restored often enough to be worth keeping
+    /// @return uint16_t*: Where to write the region's pixels, row by row, or nullptr if it isn't to be cached
+    /// @note Call commit() once the pixels are written
+    uint16_t *reserve()
+    {
+        if (m_pending == MAX_REGIONS) return nullptr;
+
+        region_t &region = m_regions[m_pending];
+        uint32_t const needed = static_cast<uint32_t>(region.width) * region.height;
+        if ((region.count < ADMIT_AFTER) || (needed > CAPACITY))
+        {
+            m_pending = MAX_REGIONS;
+            return nullptr;
+        }
+
+        // Evict regions restored less often than this one until it fits
+        while ((CAPACITY - m_used) < needed)
+        {
+            size_t victim = MAX_REGIONS;
+            for (size_t i = 0; i < MAX_REGIONS; i++)
+            {
+                if (!m_regions[i].cached || (m_regions[i].count >= region.count)) continue;
+                if ((victim == MAX_REGIONS) || (m_regions[i].count < m_regions[victim].count)) victim = i;
+            }
+
+            if (victim == MAX_REGIONS)
+            {
+                m_pending = MAX_REGIONS;
+                return nullptr;
+            }
+            _evict(victim);
+        }
+
+        region.offset = m_used;
+        m_used += needed;
+        return m_pixels + region.offset;
+    }
+
+    /// @brief Finish adding the region returned by reserve()
+    /// @param complete False if the pixels could not all be written, the space is given back
+    void commit(bool complete)
+    {
+        if (m_pending == MAX_REGIONS) return;
+
+        region_t &region = m_regions[m_pending];
+        if (complete)
+        {
+            region.cached = true;
+        }
+        else
+        {
+            m_used -= static_cast<uint32_t>(region.width) * region.height;
+        }
+        m_pending = MAX_REGIONS;
+    }
+
+    /// @brief Drop every cached region and count, e.g. when the background image changes
+    void clear()
+    {
+        for (size_t i = 0; i < MAX_REGIONS; i++)
+        {
+            m_regions[i].count = 0;
+            m_regions[i].cached = false;
+            m_regions[i].width = 0;
+        }
+        m_used = 0;
+        m_pending = MAX_REGIONS;
+    }
+
+    /// @brief Get the number of restores served from RAM
+    /// @return uint32_t: The number of hits
+    uint32_t hits() const { return m_hits; }
+
+    /// @brief Get the number of restores decoded from the SD card
+    /// @return uint32_t: The number of misses
+    uint32_t misses() const { return m_misses; }
+
+    /// @brief Get the amount of the cache in use
+    /// @return uint32_t: Bytes holding cached pixels
+    uint32_t usedBytes() const { return m_used * sizeof(uint16_t); }
+
+private:
+    struct region_t
+    {
+        int16_t x, y, width, height;
+        uint32_t offset; ///< Start of the region's pixels in m_pixels, when cached
+        uint8_t count; ///< Restores of the region, halved whenever one reaches the maximum
+        bool cached;
+    };
+
+    region_t m_regions[MAX_REGIONS];
+    uint16_t m_pixels[CAPACITY];
+    uint32_t m_used; ///< Pixels in use, cached regions are packed from the start of m_pixels
+    size_t m_pending; ///< Region of the last find(), MAX_REGIONS if none
+    uint32_t m_hits;
+    uint32_t m_misses;
+
+    /// @brief Find a region in the table
+    /// @return size_t: The region's index, or MAX_REGIONS if it isn't there
+    size_t _lookup(int16_t x, int16_t y, int16_t w, int16_t h) const
+    {
+        for (size_t i = 0; i < MAX_REGIONS; i++)
+        {
+            region_t const &region = m_regions[i];
+            if ((region.width > 0) && (region.x == x) && (region.y == y) && (region.width == w) &&
+                (region.height == h))
+            {
+                return i;
+            }
+        }
+        return MAX_REGIONS;
+    }
+
+    /// @brief Start counting a new region, replacing the least restored region that isn't cached
+    /// @return size_t: The region's index, or MAX_REGIONS if every slot holds a cached region
+    size_t _insert(int16_t x, int16_t y, int16_t w, int16_t h)
+    {
+        size_t slot = MAX_REGIONS;
+        for (size_t i = 0; i < MAX_REGIONS; i++)
+        {
+            if (m_regions[i].cached) continue;
+            if ((slot == MAX_REGIONS) || (m_regions[i].count < m_regions[slot].count)) slot = i;
+        }
+        if (slot == MAX_REGIONS) return MAX_REGIONS;
+
+        m_regions[slot] = {x, y, w, h, 0, 0, false};
+        return slot;
+    }
+
+    /// @brief Remove a cached region and pack the regions after it down to close the gap
+    /// @param idx The region to remove
+    void _evict(size_t idx)
+    {
+        region_t &region = m_regions[idx];
+        uint32_t const size = static_cast<uint32_t>(region.width) * region.height;
+        uint32_t const end = region.offset + size;
+
+        memmove(m_pixels + region.offset, m_pixels + end, (m_used - end) * sizeof(uint16_t));
+        for (size_t i = 0; i < MAX_REGIONS; i++)
+        {
+            if (m_regions[i].cached && (m_regions[i].offset > region.offset)) m_regions[i].offset -= size;
+        }
+
+        m_used -= size;
+        region.cached = false;
+    }
+
+    /// @brief Halve every count, so regions that were busy a long time ago don't hold their place forever
+    void _age()
+    {
+        for (size_t i = 0; i < MAX_REGIONS; i++)
+        {
+            m_regions[i].count /= 2;
+        }
+    }
+};
+
+} // namespace display
+#endif // __BACKGROUND_CACHE_H__
@@ -9,10 +9,17 @@
 #define __BMP_H__
 
 #include <SD.h>
+#include "render_timing.h"
+#include "rgb565.h"
+#include "sidecar.h"
 
 namespace bmp
 {
 
+/// @brief RAM budget for the row buffers used while streaming an image to the display
+/// @note 4800 bytes holds three 320 pixel rows of a 24-bit background (raw and converted), or twelve 80 pixel icon rows
+uint16_t constexpr STREAM_BUFFER_BYTES = 4800;
+
 typedef void(BMP_DRAW_CALLBACK)(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h);
 
 class BmpClass
@@ -20,93 +27,462 @@ class BmpClass
 public:
     void draw(
         File *f, BMP_DRAW_CALLBACK *bmpDrawCallback, bool useBigEndian,
-        int16_t x, int16_t y, int16_t width, int16_t heightLimit, int16_t yend = 0)
+        int16_t x, int16_t y, int16_t width, int16_t heightLimit, int16_t yend = 0,
+        File *sidecarFile = nullptr, uint32_t sidecarKey = 0)
     {
         _bmpDrawCallback = bmpDrawCallback;
         _useBigEndian = useBigEndian;
         _heightLimit = heightLimit;
+        _sidecar = sidecarFile;
+        _sidecarKey = sidecarKey;
 
         int16_t u, v;
         uint32_t xend;
 
-        getbmpparms(f);
-
-        //validate bitmap
-        if ((bmtype == 19778) && (bmwidth > 0) && (bmheight > 0) && (bm_bits_per_pixel > 0))
+        if (loadbmp(f))
         {
             u = x;
             v = y;
-            xend = width;
+            xend = (static_cast<uint32_t>(width) < bmwidth) ? width : bmwidth; //never convert past the line
+
+            drawbmtrue(f, u, v, xend, yend);
+        }
+
+        free(bmplt);
+        bmplt = nullptr;
+    }
+
+    /// @brief Draw a rectangular region of the bitmap, reading only the bytes of each line inside the region
+    /// @param f file pointer to the bitmap file
+    /// @param x x coordinate to draw the region at
+    /// @param y y coordinate to draw the region at
+    /// @param srcX left column of the region in the image
+    /// @param srcY top row of the region in the image, counted from the top whatever the line order of the file
+    /// @param w width of the region
+    /// @param h height of the region
+    /// @note The region is clipped to the image. Each line is a separate seek, so use draw() for whole images.
+    void drawRegion(
+        File *f, BMP_DRAW_CALLBACK *bmpDrawCallback, bool useBigEndian,
+        int16_t x, int16_t y, int16_t srcX, int16_t srcY, int16_t w, int16_t h)
+    {
+        _bmpDrawCallback = bmpDrawCallback;
+        _useBigEndian = useBigEndian;
+
+        if (loadbmp(f))
+        {
+            drawbmregion(f, x, y, srcX, srcY, w, h);
+        }
+
+        free(bmplt);
+        bmplt = nullptr;
+    }
+
+    /// @brief Turn transparency on or off for the draws that follow
+    /// @param enabled If true, pixels of rgb565::COLOUR_KEY are not drawn. Each opaque run of a line is passed to
+    /// the callback on its own, so transparent pixels are never sent.
+    void colourKey(bool enabled)
+    {
+        _colourKey = enabled;
+    }
+
+    /// @brief Check whether a full draw of this file would write a sidecar
+    /// @param f file pointer to the bitmap file
+    /// @param width the width the image is drawn in
+    /// @param heightLimit the height the image is drawn in
+    /// @return bool: True for 24-bit bitmaps that fit, other depths are already as small as their RGB565 form and a
+    /// clipped draw doesn't convert every pixel
+    bool sidecarSupported(File *f, int16_t const width, int16_t const heightLimit)
+    {
+        getbmpparms(f);
+        return (bmtype == 19778) && (bm_bits_per_pixel == 24) && (bmwidth <= static_cast<uint32_t>(width)) &&
+               (static_cast<int32_t>(bmheight) <= heightLimit);
+    }
+
+    /// @brief Draw a sidecar written by a previous full draw, see sidecar.h
+    /// @param f file pointer to the sidecar file
+    /// @param header the validated header of the sidecar
+    /// @note x, y, width, heightLimit and yend behave exactly as they do for draw()
+    void drawSidecar(
+        File *f, sidecar::header_t const &header, BMP_DRAW_CALLBACK *bmpDrawCallback, bool useBigEndian,
+        int16_t x, int16_t y, int16_t width, int16_t heightLimit, int16_t yend = 0)
+    {
+        _bmpDrawCallback = bmpDrawCallback;
+        _useBigEndian = useBigEndian;
+
+        int16_t const height = header.height;
+        int16_t const xend = (width < header.width) ? width : header.width;
+        bool const swapBytes = ((header.flags & sidecar::FLAG_WIRE_ORDER) != 0) != useBigEndian;
+        if ((yend == 0) || (yend > height))
+        {
+            yend = height;
+        }
+
+        int16_t ystart = 0;
+        if (height > heightLimit)
+        {
+            ystart = height - heightLimit; // don't draw if it's outside the screen
+        }
+        if (ystart >= yend)
+        {
+            return;
+        }
+
+        // Range of stored rows to draw, rows are stored top-down
+        int16_t const firstRow = height - yend;
+        int16_t const lastRow = height - ystart;
+
+        // Cropped rows can't be packed back to back, so fall back to one row at a time
+        uint16_t rowsPerBlock = 1;
+        if (xend == header.width)
+        {
+            rowsPerBlock = blockRows(header.width * 2);
+        }
+
+        uint16_t *block = (uint16_t *)malloc(static_cast<uint32_t>(rowsPerBlock) * header.width * 2);
+        if (!block)
+        {
+            return;
+        }
+
+        // Blocks are drawn top to bottom so the display can take them as one stream, read after a single seek
+        uint32_t const rowBytes = static_cast<uint32_t>(header.width) * 2;
+        f->seek(sizeof(sidecar::header_t) + static_cast<uint32_t>(firstRow) * rowBytes);
+        for (int16_t done = 0; done < (lastRow - firstRow); done += rowsPerBlock)
+        {
+            uint16_t const left = (lastRow - firstRow) - done;
+            uint16_t const rows = (left < rowsPerBlock) ? left : rowsPerBlock;
+            int16_t const row_idx = firstRow + done;
 
-            bmpRow = (uint16_t *)malloc(xend * 2);
-            if (bmpRow)
             {
-                drawbmtrue(f, u, v, xend, yend);
+                render_timing::scope_c timer(render_timing::stage_t::SD_READ);
+                for (uint16_t r = 0; r < rows; r++)
+                {
+                    f->read(block + r * xend, rowBytes);
+                }
             }
-            free(bmpRow);
+
+            // Only needed if the sidecar was written for the other byte order
+            if (swapBytes)
+            {
+                for (uint32_t i = 0; i < static_cast<uint32_t>(rows) * xend; i++)
+                {
+                    block[i] = rgb565::swap(block[i]);
+                }
+            }
+
+            int16_t const top = y + row_idx;
+            emitBlock(x, top, block, xend, rows);
         }
+
+        free(block);
     }
 
 private:
+    /// @brief Read the headers and, for indexed colour, the palette
+    /// @param f file pointer to the bitmap file
+    /// @return bool: True if the bitmap can be drawn
+    bool loadbmp(File *f)
+    {
+        getbmpparms(f);
+
+        //validate bitmap, indexed colour needs its palette
+        bool const indexed = (bm_bits_per_pixel == 1) || (bm_bits_per_pixel == 4) || (bm_bits_per_pixel == 8);
+        bool const direct = (bm_bits_per_pixel == 24) || (bm_bits_per_pixel == 32);
+        return (bmtype == 19778) && (bmwidth > 0) && (bmheight > 0) && (direct || (indexed && getbmpplt(f)));
+    }
+
+    /// @brief Draw a region of the bitmap image to the screen, see drawRegion()
+    void drawbmregion(File *f, int16_t u, int16_t v, int16_t srcX, int16_t srcY, int16_t w, int16_t h)
+    {
+        if (srcX < 0)
+        {
+            u -= srcX;
+            w += srcX;
+            srcX = 0;
+        }
+        if (srcY < 0)
+        {
+            v -= srcY;
+            h += srcY;
+            srcY = 0;
+        }
+        if ((srcX + w) > static_cast<int32_t>(bmwidth)) w = bmwidth - srcX;
+        if ((srcY + h) > static_cast<int32_t>(bmheight)) h = bmheight - srcY;
+        if ((w <= 0) || (h <= 0))
+        {
+            return;
+        }
+
+        bm_bytes_per_line = ((bm_bits_per_pixel * bmwidth + 31) / 32) * 4;
+
+        // Byte range of the region within a line. Below 8 bits per pixel the first byte can start mid-way through,
+        // so the pixels to skip in it are passed on to the conversion.
+        uint32_t const firstBit = static_cast<uint32_t>(srcX) * bm_bits_per_pixel;
+        uint32_t const endBit = static_cast<uint32_t>(srcX + w) * bm_bits_per_pixel;
+        uint32_t const firstByte = firstBit / 8;
+        uint16_t const regionBytes = (endBit + 7) / 8 - firstByte;
+        uint32_t const skip = (firstBit % 8) / bm_bits_per_pixel;
+
+        uint16_t const rowsPerBlock = blockRows(regionBytes + w * 2);
+        uint8_t *lineBuffer = (uint8_t *)malloc(regionBytes);
+        bmpRow = (uint16_t *)malloc(static_cast<uint32_t>(rowsPerBlock) * w * 2);
+        if (!lineBuffer || !bmpRow)
+        {
+            free(lineBuffer);
+            free(bmpRow);
+            return;
+        }
+
+        for (int16_t row = 0; row < h; row += rowsPerBlock)
+        {
+            uint16_t const rows = ((h - row) < rowsPerBlock) ? (h - row) : rowsPerBlock;
+
+            for (uint16_t i = 0; i < rows; i++)
+            {
+                uint32_t const imageRow = srcY + row + i;
+                uint32_t const line = bmtopdown ? imageRow : (bmheight - 1 - imageRow);
+                {
+                    render_timing::scope_c timer(render_timing::stage_t::SD_READ);
+                    f->seek(bmdataptr + line * bm_bytes_per_line + firstByte);
+                    f->read(lineBuffer, regionBytes);
+                }
+                render_timing::scope_c timer(render_timing::stage_t::CONVERT);
+                convertLine(lineBuffer, bmpRow + i * w, w, skip);
+            }
+
+            emitBlock(u, v + row, bmpRow, w, rows);
+        }
+
+        free(lineBuffer);
+        free(bmpRow);
+    }
+
     /// @brief Draw the bitmap image to the screen
     /// @param f file pointer to the bitmap file
     /// @param u starting x coordinate
     /// @param v starting y coordinate
     /// @param xend width of the image to draw
     /// @param yend height of the image to draw
-    /// @note This function will draw the image from the bottom up, so if using yend, it will stop after drawing yend
-    /// lines (Default: 0, which means the whole image)
+    /// @note yend counts lines up from the bottom of the image, so it will stop after drawing the bottom yend
+    /// lines (Default: 0, which means the whole image). Blocks are always drawn top to bottom, so the display can
+    /// take the image as one stream. Top-down files are read forwards with a single seek, bottom-up files with a
+    /// seek back per block.
     void drawbmtrue(File *f, int16_t const u, int16_t const v, uint32_t const xend, int16_t yend = 0)
     {
-        if (yend == 0)
+        if ((yend == 0) || (yend > static_cast<int32_t>(bmheight)))
         {
             yend = bmheight;
         }
 
         int16_t ystart;
-        uint32_t y;
+        uint32_t line;
         bm_bytes_per_line = ((bm_bits_per_pixel * bmwidth + 31) / 32) * 4; // bytes per line, due to 32-bit chunks
         ystart = 0;
-        if (bmheight > _heightLimit)
+        if (static_cast<int32_t>(bmheight) > _heightLimit)
         {
             ystart = bmheight - _heightLimit; // don't draw if it's outside the screen
         }
+        if (ystart >= yend)
+        {
+            return;
+        }
+
+        // Range of file lines to draw, lines are numbered in file order
+        uint32_t const firstLine = bmtopdown ? (bmheight - yend) : ystart;
+        uint32_t const lastLine = bmtopdown ? (bmheight - ystart) : yend;
 
-        // Allocate a buffer for one line of pixel data
-        uint8_t *lineBuffer = (uint8_t *)malloc(bm_bytes_per_line);
-        if (!lineBuffer)
+        // Allocate buffers for a block of raw lines and the converted pixels
+        uint16_t const rowsPerBlock = blockRows(bm_bytes_per_line + xend * 2);
+        uint8_t *lineBuffer = (uint8_t *)malloc(static_cast<uint32_t>(rowsPerBlock) * bm_bytes_per_line);
+        bmpRow = (uint16_t *)malloc(static_cast<uint32_t>(rowsPerBlock) * xend * 2);
+        if (!lineBuffer || !bmpRow)
         {
+            free(lineBuffer);
+            free(bmpRow);
             return; // Exit if memory allocation fails
         }
 
-        for (y = ystart; y < yend; y++)
+        // Only a full draw of a 24-bit image converts every pixel, so only then can the sidecar be written
+        File *sidecarFile = nullptr;
+        if (_sidecar && (ystart == 0) && (yend == static_cast<int32_t>(bmheight)) && (xend == bmwidth) && (bm_bits_per_pixel == 24))
         {
-            // Seek to the start of the current line
-            f->seek(bmdataptr + y * bm_bytes_per_line);
+            sidecarFile = _sidecar;
+            uint8_t const flags = _useBigEndian ? sidecar::FLAG_WIRE_ORDER : 0; // rows are written top-down
+            sidecar::writeHeader(sidecarFile, bmwidth, bmheight, flags, f->size(), _sidecarKey);
+        }
 
-            // Read the entire line into the buffer
-            f->read(lineBuffer, bm_bytes_per_line);
+        f->seek(bmdataptr + firstLine * bm_bytes_per_line);
 
-            // Process the line and populate bmpRow
-            for (uint32_t x = 0; x < xend; x++)
+        for (uint32_t done = 0; done < (lastLine - firstLine); done += rowsPerBlock)
+        {
+            uint32_t const left = (lastLine - firstLine) - done;
+            uint16_t const rows = (left < rowsPerBlock) ? left : rowsPerBlock;
+            line = bmtopdown ? (firstLine + done) : (lastLine - done - rows);
+
+            // Read the entire block of lines into the buffer
             {
-                uint8_t b = lineBuffer[x * (bm_bits_per_pixel / 8)];
-                uint8_t g = lineBuffer[x * (bm_bits_per_pixel / 8) + 1];
-                uint8_t r = lineBuffer[x * (bm_bits_per_pixel / 8) + 2];
+                render_timing::scope_c timer(render_timing::stage_t::SD_READ);
+                if (!bmtopdown) f->seek(bmdataptr + line * bm_bytes_per_line);
+                f->read(lineBuffer, rows * bm_bytes_per_line);
+            }
 
-                bmpRow[x] = convertToRGB565(r, g, b); // Convert to RGB565 format
+            for (uint16_t i = 0; i < rows; i++)
+            {
+                uint8_t const *src = lineBuffer + i * bm_bytes_per_line;
+
+                // Bottom-up lines are reversed so the block is always top-down for the display
+                uint16_t *dst = bmpRow + (bmtopdown ? i : (rows - 1 - i)) * xend;
+
+                // Process the line and populate its row of the block
+                render_timing::scope_c timer(render_timing::stage_t::CONVERT);
+                convertLine(src, dst, xend);
             }
 
-            // Invoke the callback for the current line
-            _bmpDrawCallback(u, v + bmheight - 1 - y, bmpRow, xend, 1);
+            // The sidecar is always top-down, the block already is
+            if (sidecarFile)
+            {
+                sidecarFile->write((uint8_t *)bmpRow, static_cast<uint32_t>(rows) * xend * 2);
+            }
+
+            // Invoke the callback once for the whole block
+            int16_t const top = bmtopdown ? (v + line) : (v + bmheight - line - rows);
+            emitBlock(u, top, bmpRow, xend, rows);
         }
 
-        // Free the allocated buffer
+        // Free the allocated buffers
         free(lineBuffer);
+        free(bmpRow);
+    }
+
+    /// @brief Pass a block of converted rows to the callback, split into opaque runs when the colour key is on
+    /// @param x x coordinate of the block
+    /// @param y y coordinate of the block
+    /// @param block the rows, top-down
+    /// @param w width of each row
+    /// @param rows number of rows
+    void emitBlock(int16_t const x, int16_t const y, uint16_t *block, int16_t const w, uint16_t const rows)
+    {
+        render_timing::scope_c timer(render_timing::stage_t::BUS);
+        uint16_t const key = _useBigEndian ? rgb565::swap(rgb565::COLOUR_KEY) : rgb565::COLOUR_KEY;
+        uint32_t const count = static_cast<uint32_t>(w) * rows;
+        bool keyed = false;
+        for (uint32_t i = 0; _colourKey && !keyed && (i < count); i++)
+        {
+            keyed = (block[i] == key);
+        }
+
+        if (!keyed)
+        {
+            _bmpDrawCallback(x, y, block, w, rows); //nothing to skip, keep the whole block in one write
+            return;
+        }
+
+        for (uint16_t r = 0; r < rows; r++)
+        {
+            uint16_t *line = block + r * w;
+            int16_t col = 0;
+            while (col < w)
+            {
+                while ((col < w) && (line[col] == key))
+                {
+                    col++;
+                }
+                int16_t const start = col;
+                while ((col < w) && (line[col] != key))
+                {
+                    col++;
+                }
+                if (col > start)
+                {
+                    _bmpDrawCallback(x + start, y + r, line + start, col - start, 1);
+                }
+            }
+        }
+    }
+
+    /// @brief Number of rows that fit in the streaming budget
+    /// @param bytesPerRow bytes of buffer needed for each row
+    /// @return uint16_t: The number of rows to read and draw at a time, at least one
+    uint16_t blockRows(uint32_t const bytesPerRow)
+    {
+        uint32_t const rows = STREAM_BUFFER_BYTES / bytesPerRow;
+        return (rows > 0) ? rows : 1;
+    }
+
+    /// @brief Convert one line of the file to RGB565
+    /// @param src the raw line as read from the file
+    /// @param dst the converted pixels
+    /// @param xend number of pixels to convert
+    /// @param skip pixels to skip at the start of src, only used below 8 bits per pixel (default: 0)
+    void convertLine(uint8_t const *src, uint16_t *dst, uint32_t const xend, uint32_t const skip = 0)
+    {
+        uint32_t x;
+        switch (bm_bits_per_pixel)
+        {
+        case 1: // 8 pixels per byte, most significant bit first
+            for (x = 0; x < xend; x++)
+            {
+                uint32_t const p = x + skip;
+                dst[x] = bmplt[(src[p >> 3] >> (7 - (p & 0x07))) & 0x01];
+            }
+            break;
+        case 4: // 2 pixels per byte, high nibble first
+            for (x = 0; x < xend; x++)
+            {
+                uint32_t const p = x + skip;
+                dst[x] = bmplt[(p & 0x01) ? (src[p >> 1] & 0x0F) : (src[p >> 1] >> 4)];
+            }
+            break;
+        case 8:
+            for (x = 0; x < xend; x++)
+            {
+                dst[x] = bmplt[src[x]];
+            }
+            break;
+        case 24: // blue first, four pixels at a time
+            rgb565::fromBGR24(src, dst, xend, _useBigEndian);
+            break;
+        default: // 32 bits, blue first
+            rgb565::fromBGRA32(src, dst, xend, _useBigEndian);
+            break;
+        }
     }
 
     uint16_t convertToRGB565(uint8_t r, uint8_t g, uint8_t b) {
-        return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+        return rgb565::fromRGB(r, g, b);
+    }
+
+    /// @brief Load the palette of an indexed colour bitmap, converting it to RGB565 once for the whole file
+    /// @param f file pointer to the bitmap file
+    /// @return bool: True if the palette was loaded into bmplt
+    bool getbmpplt(File *f)
+    {
+        // Size for every index the pixel depth can hold, so a short palette can't be read past
+        uint16_t const entries = 1 << bm_bits_per_pixel;
+        uint16_t count = (bmpltsize == 0) ? entries : bmpltsize;
+        if (count > entries)
+        {
+            count = entries;
+        }
+
+        bmplt = (uint16_t *)calloc(entries, sizeof(uint16_t));
+        if (!bmplt)
+        {
+            return false;
+        }
+
+        f->seek(14 + bmhdrsize); //palette follows the DIB header
+        for (uint16_t i = 0; i < count; i++)
+        {
+            uint8_t bgra[4];
+            if (f->read(bgra, sizeof(bgra)) != sizeof(bgra))
+            {
+                return false;
+            }
+            bmplt[i] = convertToRGB565(bgra[2], bgra[1], bgra[0]);
+            if (_useBigEndian) bmplt[i] = rgb565::swap(bmplt[i]); //indexed pixels come out in the requested order
+        }
+        return true;
     }
 
     void getbmpparms(File *f)
@@ -126,10 +502,18 @@ private:
         bmheight = 0;
         bm_bits_per_pixel = 0;
         bmpltsize = 0;
-        if ((bmhdrsize == 0x28) || (bmhdrsize == 0x38))
+        bmtopdown = false;
+        uint32_t const compression = h[30] + (h[31] << 8); //only uncompressed (BI_RGB) data is supported
+        //V4 (0x6C) and V5 (0x7C) headers extend the usual header, the fields used here are in the same place
+        bool const known_header =
+            (bmhdrsize == 0x28) || (bmhdrsize == 0x38) || (bmhdrsize == 0x6C) || (bmhdrsize == 0x7C);
+        if (known_header && (compression == 0))
         {
             bmwidth = h[18] + (h[19] << 8);   //width
-            bmheight = h[22] + (h[23] << 8);  //height
+            int32_t const height = static_cast<int32_t>(
+                h[22] | (h[23] << 8) | (static_cast<uint32_t>(h[24]) << 16) | (static_cast<uint32_t>(h[25]) << 24));
+            bmtopdown = (height < 0); //negative height means the lines are stored top-down
+            bmheight = bmtopdown ? -height : height;  //height
             bm_bits_per_pixel = h[28] + (h[29] << 8);     //bits per pixel
             bmpltsize = h[46] + (h[47] << 8); //palette size
         }
@@ -137,12 +521,16 @@ private:
 
     BMP_DRAW_CALLBACK *_bmpDrawCallback;
     bool _useBigEndian;
+    bool _colourKey = false;
     int16_t _heightLimit;
+    File *_sidecar;
+    uint32_t _sidecarKey;
 
     uint16_t bmtype, bmdataptr;                              //from header
     uint32_t bmhdrsize, bmwidth, bmheight, bm_bits_per_pixel, bmpltsize; //from DIB Header
+    bool bmtopdown;                                                      //lines stored top-down (negative height)
     uint16_t bm_bytes_per_line;                                          //bytes per line- derived
-    uint16_t *bmplt;                                        //palette- stored encoded for LCD
+    uint16_t *bmplt = nullptr;                              //palette- stored encoded for LCD
     uint16_t *bmpRow;
 };
 
@@ -0,0 +1,361 @@
+/*
+    bus_stats.h
+    Description: Counts what is sent over the display's data bus, compiled out unless BUS_STATS is defined below.
+    With BUS_STATS defined, tft_c::instance() wraps its bus in a counting_bus_c, which counts commands, data bytes,
+    address windows and repeated fills on their way to the panel. The view resets the counts at the start of each
+    transition and prints them over Serial at the end (see dump()).
+    Define BUS_HEATMAP as well to record how many pixels were written to each TILE x TILE tile of the screen, printed
+    after the counts as a grid of overdraw, e.g. 1 where every pixel of a tile was written once. A map of every pixel
+    would not fit in the board's RAM.
+*/
+
+#ifndef __BUS_STATS_H__
+#define __BUS_STATS_H__
+
+#include <Arduino.h>
+#include <Arduino_GFX_Library.h>
+
+// To count the bus traffic of each transition, define BUS_STATS below, and BUS_HEATMAP for the overdraw map too.
+// Define them here rather than in macro-pad.ino, which the Arduino IDE compiles separately from the files in src.
+// #define BUS_STATS
+// #define BUS_HEATMAP
+
+#if defined(BUS_HEATMAP) && !defined(BUS_STATS)
+#define BUS_STATS
+#endif
+
+namespace bus_stats
+{
+
+/// @brief Width and height of a heatmap tile in pixels
+uint8_t constexpr TILE = 8;
+
+/// @brief Heatmap tiles across and down the screen
+uint8_t constexpr TILES_X = 320 / TILE;
+uint8_t constexpr TILES_Y = 240 / TILE;
+
+/// @brief What has been sent over the bus since the last reset
+struct counters_t
+{
+    uint32_t commands; ///< Command bytes
+    uint32_t data_bytes; ///< Parameter and pixel bytes
+    uint32_t windows; ///< Address windows opened, one per RAMWR
+    uint32_t pixels; ///< Pixels written to the panel's memory, repeats included
+    uint32_t repeats; ///< writeRepeat calls, e.g. fills
+    uint32_t repeat_pixels; ///< Pixels sent by writeRepeat
+};
+
+#if defined(BUS_STATS)
+
+/// @brief A data bus that counts everything passed to the bus it wraps
+class counting_bus_c : public Arduino_DataBus
+{
+public:
+    explicit counting_bus_c(Arduino_DataBus *bus)
+    : m_bus(bus)
+    , m_command(0)
+    , m_params(0)
+    , m_x0(0)
+    , m_x1(0)
+    , m_y0(0)
+    , m_y1(0)
+    , m_x(0)
+    , m_y(0)
+    {
+        reset();
+    }
+
+    bool begin(int32_t speed = GFX_NOT_DEFINED, int8_t dataMode = GFX_NOT_DEFINED) override
+    {
+        return m_bus->begin(speed, dataMode);
+    }
+
+    void beginWrite() override { m_bus->beginWrite(); }
+    void endWrite() override { m_bus->endWrite(); }
+
+    void writeCommand(uint8_t c) override
+    {
+        _command(c);
+        m_bus->writeCommand(c);
+    }
+
+    void writeCommand16(uint16_t c) override
+    {
+        _command(c);
+        m_counters.commands++; // the second byte
+        m_bus->writeCommand16(c);
+    }
+
+    void writeCommandBytes(uint8_t *data, uint32_t len) override
+    {
+        for (uint32_t i = 0; i < len; i++)
+        {
+            _command(data[i]);
+        }
+        m_bus->writeCommandBytes(data, len);
+    }
+
+    void write(uint8_t d) override
+    {
+        _data(d);
+        m_bus->write(d);
+    }
+
+    void write16(uint16_t d) override
+    {
+        _data16(d);
+        m_bus->write16(d);
+    }
+
+    void writeC8D8(uint8_t c, uint8_t d) override
+    {
+        _command(c);
+        _data(d);
+        m_bus->writeC8D8(c, d);
+    }
+
+    void writeC16D16(uint16_t c, uint16_t d) override
+    {
+        _command(c);
+        m_counters.commands++; // the second byte
+        _data16(d);
+        m_bus->writeC16D16(c, d);
+    }
+
+    void writeC8D16(uint8_t c, uint16_t d) override
+    {
+        _command(c);
+        _data16(d);
+        m_bus->writeC8D16(c, d);
+    }
+
+    void writeC8D16D16(uint8_t c, uint16_t d1, uint16_t d2) override
+    {
+        _command(c);
+        _data16(d1);
+        _data16(d2);
+        m_bus->writeC8D16D16(c, d1, d2);
+    }
+
+    void writeRepeat(uint16_t p, uint32_t len) override
+    {
+        m_counters.repeats++;
+        m_counters.repeat_pixels += len;
+        m_counters.data_bytes += len * 2;
+        _pixels(len);
+        m_bus->writeRepeat(p, len);
+    }
+
+    void writePixels(uint16_t *data, uint32_t len) override
+    {
+        m_counters.data_bytes += len * 2;
+        _pixels(len);
+        m_bus->writePixels(data, len);
+    }
+
+    void writeBytes(uint8_t *data, uint32_t len) override
+    {
+        m_counters.data_bytes += len;
+        _pixels(len / 2);
+        m_bus->writeBytes(data, len);
+    }
+
+    void writeIndexedPixels(uint8_t *data, uint16_t *idx, uint32_t len) override
+    {
+        m_counters.data_bytes += len * 2;
+        _pixels(len);
+        m_bus->writeIndexedPixels(data, idx, len);
+    }
+
+    void writeIndexedPixelsDouble(uint8_t *data, uint16_t *idx, uint32_t len) override
+    {
+        m_counters.data_bytes += len * 4;
+        _pixels(len * 2);
+        m_bus->writeIndexedPixelsDouble(data, idx, len);
+    }
+
+    /// @brief Get the counts since the last reset
+    counters_t const &counters() const { return m_counters; }
+
+    /// @brief Zero the counts and the heatmap
+    void reset()
+    {
+        memset(&m_counters, 0, sizeof(m_counters));
+#if defined(BUS_HEATMAP)
+        memset(m_heatmap, 0, sizeof(m_heatmap));
+#endif
+    }
+
+#if defined(BUS_HEATMAP)
+    /// @brief Get the number of pixels written to a tile since the last reset
+    uint16_t tile(uint8_t const tx, uint8_t const ty) const { return m_heatmap[ty][tx]; }
+#endif
+
+private:
+    /// @brief Commands whose parameters are followed, to know where pixels land
+    static uint8_t constexpr CASET = 0x2A;
+    static uint8_t constexpr PASET = 0x2B;
+    static uint8_t constexpr RAMWR = 0x2C;
+
+    Arduino_DataBus *m_bus;
+    counters_t m_counters;
+    uint8_t m_command; ///< The last command sent
+    uint8_t m_params; ///< Parameter bytes sent since it
+    uint16_t m_x0, m_x1, m_y0, m_y1; ///< The address window set by CASET and PASET
+    uint16_t m_x, m_y; ///< Where the next pixel lands
+#if defined(BUS_HEATMAP)
+    uint16_t m_heatmap[TILES_Y][TILES_X];
+#endif
+
+    void _command(uint8_t const c)
+    {
+        m_counters.commands++;
+        m_command = c;
+        m_params = 0;
+        if (c == RAMWR)
+        {
+            m_counters.windows++;
+            m_x = m_x0;
+            m_y = m_y0;
+        }
+    }
+
+    void _data(uint8_t const d)
+    {
+        m_counters.data_bytes++;
+        if ((m_command == CASET) || (m_command == PASET))
+        {
+            // Start then end, each most significant byte first
+            if (m_params < 4)
+            {
+                uint16_t *value = (m_command == CASET) ? ((m_params < 2) ? &m_x0 : &m_x1)
+                                                       : ((m_params < 2) ? &m_y0 : &m_y1);
+                *value = ((m_params % 2) == 0) ? (static_cast<uint16_t>(d) << 8) : (*value | d);
+            }
+            m_params++;
+        }
+        else if ((m_command == RAMWR) && ((++m_params % 2) == 0))
+        {
+            _pixels(1); // two bytes per pixel
+        }
+    }
+
+    void _data16(uint16_t const d)
+    {
+        if (m_command == RAMWR)
+        {
+            m_counters.data_bytes += 2;
+            _pixels(1);
+            return;
+        }
+        _data(d >> 8);
+        _data(d & 0xFF);
+    }
+
+    /// @brief Count pixels written to the window, adding them to the tiles they land in
+    void _pixels(uint32_t count)
+    {
+        m_counters.pixels += count;
+#if defined(BUS_HEATMAP)
+        if ((m_x1 < m_x0) || (m_y1 < m_y0)) return;
+        while (count > 0)
+        {
+            // The rest of this row of the window, a tile at a time
+            uint16_t const row_left = m_x1 - m_x + 1;
+            uint16_t const span = (count < row_left) ? static_cast<uint16_t>(count) : row_left;
+            uint16_t const end = m_x + span;
+            for (uint16_t x = m_x; x < end;)
+            {
+                uint16_t const tile_end = ((x / TILE) + 1) * TILE;
+                uint16_t const n = ((tile_end < end) ? tile_end : end) - x;
+                if (((x / TILE) < TILES_X) && ((m_y / TILE) < TILES_Y)) m_heatmap[m_y / TILE][x / TILE] += n;
+                x += n;
+            }
+            count -= span;
+            m_x = end;
+            if (m_x > m_x1)
+            {
+                m_x = m_x0;
+                if (++m_y > m_y1) m_y = m_y0; // the panel wraps back to the start once the window is full
+            }
+        }
+#endif
+    }
+};
+
+/// @brief Get the bus created by tft_c::instance()
+/// @param bus The bus to wrap, only passed on the first call
+/// @return counting_bus_c*: The counting bus, nullptr before the display has been created
+inline counting_bus_c *bus(Arduino_DataBus *wrap = nullptr)
+{
+    static counting_bus_c *counting = nullptr;
+    if ((counting == nullptr) && (wrap != nullptr)) counting = new counting_bus_c(wrap);
+    return counting;
+}
+
+/// @brief Zero the counts, e.g. at the start of a transition
+inline void reset()
+{
+    if (bus()) bus()->reset();
+}
+
+/// @brief Print the counts, and with BUS_HEATMAP the heatmap, over Serial
+/// @param label What was drawn, e.g. the screen
+inline void dump(char const *label)
+{
+    if (!bus()) return;
+
+    counters_t const &c = bus()->counters();
+    Serial.print("Bus ");
+    Serial.print(label);
+    Serial.print(": ");
+    Serial.print(c.commands);
+    Serial.print(" commands, ");
+    Serial.print(c.data_bytes);
+    Serial.print(" data bytes, ");
+    Serial.print(c.windows);
+    Serial.print(" windows, ");
+    Serial.print(c.pixels);
+    Serial.print(" pixels, ");
+    Serial.print(c.repeats);
+    Serial.print(" repeats of ");
+    Serial.print(c.repeat_pixels);
+    Serial.println(" pixels");
+
+#if defined(BUS_HEATMAP)
+    // Overdraw of each tile, '.' where nothing was written and '+' for 10 or more
+    uint16_t constexpr AREA = TILE * TILE;
+    for (uint8_t ty = 0; ty < TILES_Y; ty++)
+    {
+        char line[TILES_X + 1];
+        for (uint8_t tx = 0; tx < TILES_X; tx++)
+        {
+            uint16_t const writes = bus()->tile(tx, ty);
+            uint16_t const overdraw = (writes + AREA - 1) / AREA;
+            line[tx] = (writes == 0) ? '.' : ((overdraw > 9) ? '+' : static_cast<char>('0' + overdraw));
+        }
+        line[TILES_X] = '\0';
+        Serial.println(line);
+    }
+#endif
+}
+
+/// @brief Wrap the display's bus so it is counted
+/// @param bus The bus the display would use
+/// @return Arduino_DataBus*: The bus to give the display
+inline Arduino_DataBus *wrap(Arduino_DataBus *bus)
+{
+    return bus_stats::bus(bus);
+}
+
+#else
+
+// Compiled out, the calls are left in place and cost nothing
+inline void reset() {}
+inline void dump(char const *) {}
+inline Arduino_DataBus *wrap(Arduino_DataBus *bus) { return bus; }
+
+#endif // BUS_STATS
+
+} // namespace bus_stats
+#endif // __BUS_STATS_H__
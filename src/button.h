@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include "constants.h"
 #include "limits.h"
+#include "text_layout.h"
 
 namespace gui
 {
@@ -36,20 +37,23 @@ public:
     /// @param width The width of the button in pixels
     /// @param height The height of the button in pixels
     button_base_c(int16_t x = 0, int16_t y = 0, int16_t width = 0, int16_t height = 0, const char* name = "")
-    : m_id(UINT_MAX)
+    : m_callback_function(nullptr)
+    , m_callback_context(nullptr)
+    , m_draw_function(nullptr)
+    , m_draw_context(nullptr)
+    , m_id(UINT16_MAX)
     , m_active(true)
     , m_pressed(false)
+    , m_fill_colour(DEFAULT_FILL_COLOUR)
+    , m_txt_colour(DEFAULT_TEXT_COLOUR)
+    , m_border_colour(DEFAULT_BORDER_COLOUR)
     , m_x(x)
     , m_y(y)
     , m_width(width)
     , m_height(height)
     , m_image_file("")
+    , m_transparent(false)
     , m_name(name)
-    , m_callback_function(nullptr)
-    , m_callback_context(nullptr)
-    , m_fill_colour(DEFAULT_FILL_COLOUR)
-    , m_txt_colour(DEFAULT_TEXT_COLOUR)
-    , m_border_colour(DEFAULT_BORDER_COLOUR)
     , m_fill_colour_pressed(DEFAULT_FILL_COLOUR_PRESSED)
     , m_txt_colour_pressed(DEFAULT_TEXT_COLOUR_PRESSED)
     , m_border_colour_pressed(DEFAULT_BORDER_COLOUR_PRESSED)
@@ -57,31 +61,36 @@ public:
     , m_txt_colour_disabled(DEFAULT_TEXT_COLOUR_DISABLED)
     , m_border_colour_disabled(DEFAULT_BORDER_COLOUR_DISABLED)
     {
+        m_text_layout.invalidate();
     }
 
     /// @brief copy constructor for the button_base_c class
     /// @param rhs The button to copy
     button_base_c(button_base_c const& rhs)
-    : m_id(rhs.m_id)
+    : m_callback_function(rhs.m_callback_function)
+    , m_callback_context(rhs.m_callback_context)
+    , m_draw_function(nullptr)
+    , m_draw_context(nullptr)
+    , m_id(rhs.m_id)
     , m_active(rhs.m_active)
     , m_pressed(rhs.m_pressed)
+    , m_fill_colour(rhs.m_fill_colour)
+    , m_txt_colour(rhs.m_txt_colour)
+    , m_border_colour(rhs.m_border_colour)
     , m_x(rhs.m_x)
     , m_y(rhs.m_y)
     , m_width(rhs.m_width)
     , m_height(rhs.m_height)
     , m_image_file(rhs.m_image_file)
+    , m_transparent(rhs.m_transparent)
     , m_name(rhs.m_name)
-    , m_callback_function(rhs.m_callback_function)
-    , m_callback_context(rhs.m_callback_context)
-    , m_fill_colour(rhs.m_fill_colour)
-    , m_txt_colour(rhs.m_txt_colour)
-    , m_border_colour(rhs.m_border_colour)
     , m_fill_colour_pressed(rhs.m_fill_colour_pressed)
     , m_txt_colour_pressed(rhs.m_txt_colour_pressed)
     , m_border_colour_pressed(rhs.m_border_colour_pressed)
     , m_fill_colour_disabled(rhs.m_fill_colour_disabled)
     , m_txt_colour_disabled(rhs.m_txt_colour_disabled)
     , m_border_colour_disabled(rhs.m_border_colour_disabled)
+    , m_text_layout(rhs.m_text_layout)
     {
     }
 
@@ -100,6 +109,7 @@ public:
             this->m_width = rhs.m_width;
             this->m_height = rhs.m_height;
             this->m_image_file = rhs.m_image_file;
+            this->m_transparent = rhs.m_transparent;
             this->m_name = rhs.m_name;
             this->m_callback_function = rhs.m_callback_function;
             this->m_callback_context = rhs.m_callback_context;
@@ -112,6 +122,7 @@ public:
             this->m_fill_colour_disabled = rhs.m_fill_colour_disabled;
             this->m_txt_colour_disabled = rhs.m_txt_colour_disabled;
             this->m_border_colour_disabled = rhs.m_border_colour_disabled;
+            this->m_text_layout = rhs.m_text_layout;
         }
         return *this;
     }
@@ -186,19 +197,41 @@ public:
     
     /// @brief Set the file path name for the image to be displayed on the button
     /// @param file The file path name
-    void imageFilePath(String const file) { this->m_image_file = file; }
+    /// @note The image is taken to be opaque until transparent is set
+    void imageFilePath(String const file)
+    {
+        this->m_image_file = file;
+        this->m_transparent = false;
+    }
     
     /// @brief Get the file path name for the image to be displayed on the button
     /// @return String: The file path name
     String imageFilePath() const { return this->m_image_file; }
+
+    /// @brief Set whether the image drawn over the button leaves pixels undrawn, showing what is behind it
+    /// @param transparent True if the image has transparent pixels, looked up once when the image is set
+    void transparent(bool const transparent) { this->m_transparent = transparent; }
+
+    /// @brief Get whether what is behind the button shows through its image
+    /// @return bool: True if the button doesn't cover its whole rectangle
+    bool transparent() const { return this->m_transparent; }
     
     /// @brief Set the name of the button
     /// @param name The name of the button
-    void name(String const name) { this->m_name = name; }
+    void name(String const name)
+    {
+        this->m_name = name;
+        this->m_text_layout.invalidate();
+    }
     
     /// @brief Get the name of the button
-    /// @return String: The name of the button
-    String name() const { return this->m_name; }
+    /// @return String const&: The name of the button
+    String const &name() const { return this->m_name; }
+
+    /// @brief Get the layout of the name, kept between draws so an unchanged label isn't laid out again
+    /// @return text_layout::layout_t*: The layout, check it with text_layout::layout_t::valid before use
+    /// @note The layout is a cache, so it can be filled in through a const button
+    text_layout::layout_t *textLayout() const { return &this->m_text_layout; }
     
     /// @brief Get the x coordinate of the button
     /// @return int16_t: The x coordinate of the button
@@ -238,7 +271,11 @@ public:
     /// @brief Set the width of the button
     /// @param x The width of the button
     /// @note This is the width of the button in pixels
-    void width(int16_t const x) { this->m_width = x; }
+    void width(int16_t const x)
+    {
+        this->m_width = x;
+        this->m_text_layout.invalidate();
+    }
 
     /// @brief Get the height of the button
     /// @return int16_t: The height of the button
@@ -248,7 +285,11 @@ public:
     /// @brief Set the height of the button
     /// @param y The height of the button
     /// @note This is the height of the button in pixels
-    void height(int16_t const y) { this->m_height = y; }
+    void height(int16_t const y)
+    {
+        this->m_height = y;
+        this->m_text_layout.invalidate();
+    }
 
     /// @brief Set the fill colour of the button
     /// @param colour The fill colour of the button in RGB565 format
@@ -341,6 +382,7 @@ private:
     int16_t m_width;
     int16_t m_height;
     String m_image_file;
+    bool m_transparent;
     String m_name;
 
     int m_fill_colour_pressed;
@@ -349,6 +391,8 @@ private:
     int m_fill_colour_disabled;
     int m_txt_colour_disabled;
     int m_border_colour_disabled;
+
+    mutable text_layout::layout_t m_text_layout;
 };
 
 } // namespace gui
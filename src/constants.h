@@ -58,6 +58,7 @@ uint16_t constexpr DEFAULT_MENU_BUTTON_WIDTH = 106; // Width of the buttons in t
 uint16_t constexpr DEFAULT_MENU_BUTTON_HEIGHT = 60; // Height of the buttons in the main menu
 uint16_t constexpr MACRO_SELECT_OPTION_WIDTH = 320; // Width of the macro select options
 uint16_t constexpr MACRO_SELECT_OPTION_HEIGHT = 30; // Height of the macro select options
+uint16_t constexpr MACRO_SELECT_THUMBNAIL_SLOT = MACRO_SELECT_OPTION_HEIGHT; // Width of the icon thumbnail on the left of a macro select option
 
 // Home screen Button locations
 uint16_t constexpr HOME_SCREEN_ROW_1_Y = 0; // Y coordinate of the first row of buttons on the home screen
@@ -21,7 +21,7 @@ inline size_t parseCSVLine(String input, String components[], size_t const compo
 
     size_t num_of_delims = 0;
     {
-        size_t idx = 0;
+        int idx = 0;
         // count delimeters
         while (idx != -1)
         {
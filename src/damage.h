@@ -0,0 +1,132 @@
+/*
+    damage.h
+    Description: Tracks regions of the screen that need the background redrawn.
+    When widgets are removed or moved their rectangles are added here. Rectangles the next screen's widgets will
+    completely paint over are dropped, and only what is left is restored from the background image.
+*/
+
+#ifndef __DAMAGE_H__
+#define __DAMAGE_H__
+
+#include <Arduino.h>
+#include "wireframe.h"
+
+namespace gui
+{
+
+class damage_c
+{
+public:
+    /// @brief Most rectangles held before they are merged into one covering them all
+    static size_t constexpr MAX_RECTS = 16;
+
+    /// @brief type alias for the function that redraws the background in a rectangle
+    using restoreCallback = void (*)(void*, wf_element_t const &);
+
+    /// @brief Constructor
+    damage_c()
+    : m_count(0)
+    {
+    }
+
+    /// @brief Mark a rectangle as needing the background redrawn
+    /// @param rect The rectangle
+    void add(wf_element_t const &rect)
+    {
+        if ((rect.width <= 0) || (rect.height <= 0)) return;
+
+        for (size_t i = 0; i < m_count; i++)
+        {
+            if (contains(m_rects[i], rect)) return;
+        }
+
+        // Drop rectangles the new one already covers
+        size_t kept = 0;
+        for (size_t i = 0; i < m_count; i++)
+        {
+            if (!contains(rect, m_rects[i])) m_rects[kept++] = m_rects[i];
+        }
+        m_count = kept;
+
+        if (m_count == MAX_RECTS)
+        {
+            // Out of room, restore more than needed rather than lose damage
+            for (size_t i = 1; i < m_count; i++)
+            {
+                m_rects[0] = bounds(m_rects[0], m_rects[i]);
+            }
+            m_rects[0] = bounds(m_rects[0], rect);
+            m_count = 1;
+            return;
+        }
+
+        m_rects[m_count++] = rect;
+    }
+
+    /// @brief Tell the tracker an opaque widget is about to be drawn
+    /// @param rect The widget's rectangle
+    /// @note Damage completely inside the widget is dropped, the widget paints over it anyway
+    void cover(wf_element_t const &rect)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < m_count; i++)
+        {
+            if (!contains(rect, m_rects[i])) m_rects[kept++] = m_rects[i];
+        }
+        m_count = kept;
+    }
+
+    /// @brief Restore every damaged rectangle and clear the damage
+    /// @param restore The function that redraws the background in a rectangle
+    /// @param ctx The context in which to invoke the restore function
+    /// @return uint32_t: The number of pixels restored
+    uint32_t flush(restoreCallback restore, void *ctx)
+    {
+        uint32_t pixels = 0;
+        for (size_t i = 0; i < m_count; i++)
+        {
+            restore(ctx, m_rects[i]);
+            pixels += static_cast<uint32_t>(m_rects[i].width) * m_rects[i].height;
+        }
+        m_count = 0;
+        return pixels;
+    }
+
+    /// @brief Forget all damage, e.g. after the whole background has been redrawn
+    void clear() { m_count = 0; }
+
+    /// @brief Get the number of damaged rectangles
+    /// @return size_t: The number of rectangles
+    size_t count() const { return m_count; }
+
+    /// @brief Check if one rectangle is completely inside another
+    /// @param outer The larger rectangle
+    /// @param inner The rectangle to check
+    /// @return bool: True if inner is inside outer
+    static bool contains(wf_element_t const &outer, wf_element_t const &inner)
+    {
+        return (inner.x >= outer.x) && (inner.y >= outer.y) &&
+               ((inner.x + inner.width) <= (outer.x + outer.width)) &&
+               ((inner.y + inner.height) <= (outer.y + outer.height));
+    }
+
+    /// @brief Get the smallest rectangle covering two rectangles
+    /// @param a The first rectangle
+    /// @param b The second rectangle
+    /// @return wf_element_t: The bounding rectangle
+    static wf_element_t bounds(wf_element_t const &a, wf_element_t const &b)
+    {
+        int16_t const x = (a.x < b.x) ? a.x : b.x;
+        int16_t const y = (a.y < b.y) ? a.y : b.y;
+        int16_t const right = ((a.x + a.width) > (b.x + b.width)) ? (a.x + a.width) : (b.x + b.width);
+        int16_t const bottom = ((a.y + a.height) > (b.y + b.height)) ? (a.y + a.height) : (b.y + b.height);
+        return {x, y, static_cast<int16_t>(right - x), static_cast<int16_t>(bottom - y)};
+    }
+
+private:
+    wf_element_t m_rects[MAX_RECTS];
+    size_t m_count;
+};
+
+} // namespace gui
+#endif // __DAMAGE_H__
@@ -0,0 +1,132 @@
+/*
+    icon_pack.h
+    Description: Icon pack files ("/icons/icons.pak", and "/icons/thumbs.pak" for thumbnails), written by
+    tools/bmp_tool.py.
+    One file holds every icon already converted for the display, so drawing an icon is a seek within a file that is
+    kept open instead of a directory lookup, open and header parse per icon.
+
+    Layout:
+        header_t
+        entry_t entries[count]          Sorted by name, so an icon is found with a binary search on the card
+        image data                      Each entry's data starts at its offset, see format_t
+*/
+
+#ifndef __ICON_PACK_H__
+#define __ICON_PACK_H__
+
+#include <SD.h>
+
+namespace icon_pack
+{
+
+/// @brief Where the display looks for the pack
+char constexpr PATH[] = "/icons/icons.pak";
+
+/// @brief Where the display looks for the thumbnail pack, the same layout holding small copies of the icons for lists
+char constexpr THUMBNAIL_PATH[] = "/icons/thumbs.pak";
+
+/// @brief Width and height of the thumbnails, tools/bmp_tool.py thumbs writes them this size by default
+uint8_t constexpr THUMBNAIL_SIZE = 24;
+
+/// @brief Bump when the layout changes, older packs are then ignored and the loose icons are drawn instead
+/// @note Version 2 stores pixels most significant byte first, version 1 packs must be rebuilt
+uint8_t constexpr VERSION = 2;
+
+/// @brief Longest icon name, an 8.3 file name such as "A_FLA039.BMP"
+uint8_t constexpr NAME_LENGTH = 12;
+
+/// @brief Set in an entry's flags if the icon has pixels of rgb565::COLOUR_KEY, which are left undrawn
+uint8_t constexpr FLAG_TRANSPARENT = 0x01;
+
+/// @brief How an icon's pixels are stored
+enum class format_t : uint8_t
+{
+    RAW565 = 0, ///< width * height RGB565 pixels, rows top-down, most significant byte first
+    RLE = 1 ///< A complete RLE image, see rle.h
+};
+
+/// @brief Header at the start of every pack
+struct header_t
+{
+    uint8_t magic[4];
+    uint8_t version;
+    uint8_t flags; ///< Reserved
+    uint16_t count; ///< Number of entries in the directory
+};
+
+/// @brief One directory entry
+struct entry_t
+{
+    char name[NAME_LENGTH]; ///< Upper case, padded with '\0', not terminated when all 12 characters are used
+    uint32_t offset; ///< Start of the icon's data in the pack
+    uint16_t width;
+    uint16_t height;
+    uint8_t format; ///< See format_t
+    uint8_t flags; ///< See FLAG_TRANSPARENT
+    uint8_t reserved[2];
+};
+
+/// @brief Read and validate the header of a pack
+/// @param f The pack file
+/// @param header The header read from the file
+/// @return bool: True if the file is a pack this version can read
+inline bool readHeader(File *f, header_t *header)
+{
+    f->seek(0);
+    if (f->read(reinterpret_cast<uint8_t *>(header), sizeof(header_t)) != sizeof(header_t)) return false;
+
+    return (header->magic[0] == 'I') && (header->magic[1] == 'P') && (header->magic[2] == 'K') &&
+           (header->magic[3] == '5') && (header->version == VERSION);
+}
+
+/// @brief Compare an icon name with a directory entry's name, ignoring case
+/// @param name The name being looked up
+/// @param entry The entry's name
+/// @return int: Less than, equal to or greater than zero, as for strcmp
+inline int compareName(String const &name, char const *entry)
+{
+    for (uint8_t i = 0; i < NAME_LENGTH; i++)
+    {
+        char const a = (i < name.length()) ? toupper(name[i]) : '\0';
+        char const b = entry[i];
+        if (a != b) return static_cast<uint8_t>(a) - static_cast<uint8_t>(b);
+        if (a == '\0') return 0;
+    }
+
+    // Every entry character matched, the name only matches if it ends here too
+    return (name.length() > NAME_LENGTH) ? 1 : 0;
+}
+
+/// @brief Find an icon in the pack's directory
+/// @param f The pack file
+/// @param count The number of entries, from the header
+/// @param name The icon's file name, e.g. "A_FLA039.bmp"
+/// @param entry The entry found
+/// @return bool: True if the icon is in the pack
+inline bool find(File *f, uint16_t const count, String const &name, entry_t *entry)
+{
+    int32_t low = 0;
+    int32_t high = static_cast<int32_t>(count) - 1;
+
+    while (low <= high)
+    {
+        int32_t const mid = (low + high) / 2;
+        f->seek(sizeof(header_t) + static_cast<uint32_t>(mid) * sizeof(entry_t));
+        if (f->read(reinterpret_cast<uint8_t *>(entry), sizeof(entry_t)) != sizeof(entry_t)) return false;
+
+        int const cmp = compareName(name, entry->name);
+        if (cmp == 0) return true;
+        if (cmp < 0)
+        {
+            high = mid - 1;
+        }
+        else
+        {
+            low = mid + 1;
+        }
+    }
+    return false;
+}
+
+} // namespace icon_pack
+#endif // __ICON_PACK_H__
@@ -221,7 +221,7 @@ inline void initTable()
 /// @return uint8_t: The key code
 inline uint8_t getKeyCode(String const& key)
 {
-    uint8_t code = NULL;
+    uint8_t code = 0;
 
     if (key_table.containsKey(key))
     {
@@ -54,6 +54,10 @@ public:
         }
     }
 
+    /// @brief copy constructor for the macro_c type
+    /// @param other The macro to copy
+    macro_c(macro_c const &other) = default;
+
     /// @brief operator overload for the assignment operator
     /// @param other The macro to assign to this macro
     /// @return macro_c&: A reference to this macro
@@ -33,8 +33,8 @@ public:
         m_macro_count = _availableMacros();
         _initialiseTables();
 
-        m_min_id = INT_MAX;
-        m_max_id = INT_MIN;
+        m_min_id = UINT16_MAX;
+        m_max_id = 0;
 
         SimpleVector<int> ids = m_macro_names.keys();
         for (const int& id : ids)
@@ -77,9 +77,17 @@ public:
         return _queryMacros(ids, names);
     }
 
-    size_t getMacroOptions(size_t const qty, uint16_t *ids, String *names, uint16_t const start = 0)
+    /// @brief Get a page of macros for the macro select list
+    /// @param qty The number of macros to get
+    /// @param ids The ids of the macros found
+    /// @param names The names of the macros found
+    /// @param start The first id to look from
+    /// @param images The icons of the macros found, read from the macro file only when given
+    /// @return size_t: The number of macros found
+    size_t getMacroOptions(
+        size_t const qty, uint16_t *ids, String *names, uint16_t const start = 0, String *images = nullptr)
     {
-        return _getMacroOptions(qty, ids, names, start);
+        return _getMacroOptions(qty, ids, names, start, images);
     }
 
     /// @brief Get the minimum and maximum macros ids
@@ -103,9 +111,9 @@ private:
         String names[m_macro_count];
         macro::macro_c codes[m_macro_count]; 
         {
-            String ignore[m_macro_count]; // ignore the file paths
-            int query_count = _queryMacros(ids, names);
-            int read_count = _readMacros(ids, m_macro_count, names, ignore, codes);
+            String ignore[m_macro_count]; // ignore the file paths, thumbnails read them a page at a time
+            _queryMacros(ids, names);
+            _readMacros(ids, m_macro_count, names, ignore, codes);
         }
 
         if (!m_macro_names.isEmpty())
@@ -113,7 +121,7 @@ private:
             m_macro_names.clear();
         }
 
-        for (size_t i = 0; i < m_macro_count; i++)
+        for (int i = 0; i < m_macro_count; i++)
         {
             m_macro_names.put(ids[i], names[i]);
         }
@@ -174,7 +182,7 @@ private:
             csv::parseCSVLine(line, entries, 64);
             id = entries[0];
             
-            for (int i = 0; i < size; i++)
+            for (size_t i = 0; i < size; i++)
             {
                 if (id == String(ids[i])) // Only load the ones requested
                 {
@@ -226,7 +234,8 @@ private:
         return count; // return the number of macros loaded
     }
 
-    size_t _getMacroOptions(size_t const qty, uint16_t *ids, String *names, uint16_t const start = 0)
+    size_t _getMacroOptions(
+        size_t const qty, uint16_t *ids, String *names, uint16_t const start = 0, String *images = nullptr)
     {
         size_t count = 0;
         uint16_t id = start;
@@ -236,14 +245,55 @@ private:
             while (!m_macro_names.exists(id))
             {
                 id++; // increment the id
-                if (id > m_max_id) return count; // we've checked every possible id
+                if (id > m_max_id) break; // we've checked every possible id
             }
+            if (id > m_max_id) break;
 
             ids[i] = id;
             names[i] = m_macro_names.getElement(id);
             count++;
             id++;
         }
+
+        if (images) _readImages(ids, count, images);
+        return count;
+    }
+
+    /// @brief Read the icon file names of a few macros from the macro file
+    /// @param ids The ids of the macros
+    /// @param size The number of macros
+    /// @param images The icon file names, left empty for ids not in the file
+    /// @return size_t: The number of icon file names read
+    /// @note Read here rather than kept with the names, so RAM doesn't grow with the number of macros
+    size_t _readImages(uint16_t const *ids, size_t const size, String *images)
+    {
+        size_t count = 0;
+        if (size == 0) return count;
+
+        File file = SD.open("macros.csv");
+        if (!file) return count; // the list is still usable without thumbnails
+
+        sd::readLine(&file); // read header
+
+        while (count < size && file.available())
+        {
+            String line = sd::readLine(&file);
+            String entries[3];
+            csv::parseCSVLine(line, entries, 3); // id, name and icon, the macro codes aren't needed
+
+            uint16_t const id = static_cast<uint16_t>(entries[0].toInt());
+            for (size_t i = 0; i < size; i++)
+            {
+                if (ids[i] == id)
+                {
+                    images[i] = entries[2];
+                    count++;
+                    break;
+                }
+            }
+        }
+        file.close();
+
         return count;
     }
 };
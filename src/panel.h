@@ -0,0 +1,69 @@
+/*
+    panel.h
+    Description: The drawing primitives the display driver sends pixels with.
+    The driver draws images, backgrounds and buttons through a panel_abstract_c rather than the GFX library directly,
+    so the panel can be swapped for another backend, e.g. panel_framebuffer_c (see panel_framebuffer.h) to render on
+    a host and compare the result pixel for pixel. Laid out text (drawTextInCanvas, drawTextLayout) is drawn with the
+    library's font through the panel too. Only displayMessage and displayError, the full screen messages shown when
+    something has gone wrong, still draw on the ILI9341 through the library and are not seen by other backends.
+*/
+
+#ifndef __PANEL_H__
+#define __PANEL_H__
+
+#include <stdint.h>
+
+namespace display
+{
+
+class panel_abstract_c
+{
+public:
+    virtual ~panel_abstract_c() {}
+
+    /// @brief Get the width of the panel in its current orientation
+    /// @return int16_t: The width in pixels
+    virtual int16_t width() = 0;
+
+    /// @brief Get the height of the panel in its current orientation
+    /// @return int16_t: The height in pixels
+    virtual int16_t height() = 0;
+
+    /// @brief Start a transaction, the write calls below must be made inside one
+    virtual void startWrite() = 0;
+
+    /// @brief End a transaction
+    virtual void endWrite() = 0;
+
+    /// @brief Set the window the following pixels fill, left to right then top to bottom
+    /// @param x The x coordinate of the window
+    /// @param y The y coordinate of the window
+    /// @param w The width of the window
+    /// @param h The height of the window
+    virtual void writeAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) = 0;
+
+    /// @brief Send pixels to the window
+    /// @param data The pixels in wire order, most significant byte first
+    /// @param len The number of bytes, two per pixel
+    virtual void writeBytes(uint8_t *data, uint32_t len) = 0;
+
+    /// @brief Send one colour repeated to the window
+    /// @param colour The colour in native order
+    /// @param len The number of pixels
+    virtual void writeRepeat(uint16_t colour, uint32_t len) = 0;
+
+    /// @brief Fill a rectangle, clipped to the panel
+    /// @param colour The colour in native order
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) = 0;
+
+    /// @brief Draw the outline of a rectangle, clipped to the panel
+    /// @param colour The colour in native order
+    virtual void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) = 0;
+
+    /// @brief Draw a bitmap, clipped to the panel
+    /// @param bitmap The pixels in wire order, w by h
+    virtual void draw16bitBeRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h) = 0;
+};
+
+} // namespace display
+#endif // __PANEL_H__
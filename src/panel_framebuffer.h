@@ -0,0 +1,265 @@
+/*
+    panel_framebuffer.h
+    Description: A panel backend that draws into RAM instead of the ILI9341, for rendering on a host.
+    Every primitive is counted along with the bytes it would have put on the bus, so a rendering change can be
+    measured in bytes as well as checked pixel for pixel. The frame can be written out as a binary PPM, and compared
+    with one written earlier to catch a redraw change that alters what is shown.
+    The frame is 150 KB, far more than the board has, so this is only for host builds:
+        display::panel_framebuffer_c panel;
+        display::usePanel(&panel);
+        ... draw ...
+        panel.writePPM("home.ppm");
+    test/render_test.cpp renders every screen this way and compares them with the goldens in test/golden.
+*/
+
+#ifndef __PANEL_FRAMEBUFFER_H__
+#define __PANEL_FRAMEBUFFER_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "panel.h"
+
+namespace display
+{
+
+/// @brief Primitives sent to a panel_framebuffer_c
+struct panel_stats_t
+{
+    uint32_t windows; ///< Address windows set, including those set by fills and bitmaps
+    uint32_t pixel_writes; ///< writeBytes calls
+    uint32_t pixel_bytes; ///< Bytes sent by writeBytes
+    uint32_t repeats; ///< writeRepeat calls
+    uint32_t repeat_pixels; ///< Pixels filled by writeRepeat
+    uint32_t fills; ///< fillRect and drawRect calls
+    uint32_t fill_pixels; ///< Pixels drawn by fillRect and drawRect
+    uint32_t bitmaps; ///< draw16bitBeRGBBitmap calls
+    uint32_t bus_bytes; ///< Everything above as bytes on the bus, commands included
+};
+
+class panel_framebuffer_c : public panel_abstract_c
+{
+public:
+    static int16_t constexpr WIDTH = 320;
+    static int16_t constexpr HEIGHT = 240;
+
+    /// @brief Bytes on the bus to set an address window: CASET and PASET with 4 bytes each, then RAMWR
+    static uint32_t constexpr WINDOW_BYTES = 11;
+
+    panel_framebuffer_c()
+    {
+        clear(0);
+        resetStats();
+    }
+
+    int16_t width() override { return WIDTH; }
+    int16_t height() override { return HEIGHT; }
+    void startWrite() override {}
+    void endWrite() override {}
+
+    void writeAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) override
+    {
+        m_window_x = x;
+        m_window_y = y;
+        m_window_w = w;
+        m_window_h = h;
+        m_window_pos = 0;
+        m_stats.windows++;
+        m_stats.bus_bytes += WINDOW_BYTES;
+    }
+
+    void writeBytes(uint8_t *data, uint32_t len) override
+    {
+        m_stats.pixel_writes++;
+        m_stats.pixel_bytes += len;
+        m_stats.bus_bytes += len;
+        for (uint32_t i = 0; (i + 1) < len; i += 2)
+        {
+            _windowPixel((static_cast<uint16_t>(data[i]) << 8) | data[i + 1]);
+        }
+    }
+
+    void writeRepeat(uint16_t colour, uint32_t len) override
+    {
+        m_stats.repeats++;
+        m_stats.repeat_pixels += len;
+        m_stats.bus_bytes += len * 2;
+        for (uint32_t i = 0; i < len; i++)
+        {
+            _windowPixel(colour);
+        }
+    }
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) override
+    {
+        if (!_clip(&x, &y, &w, &h)) return;
+
+        m_stats.fills++;
+        m_stats.fill_pixels += static_cast<uint32_t>(w) * h;
+        m_stats.windows++;
+        m_stats.bus_bytes += WINDOW_BYTES + static_cast<uint32_t>(w) * h * 2;
+        for (int16_t row = y; row < (y + h); row++)
+        {
+            for (int16_t col = x; col < (x + w); col++)
+            {
+                m_frame[row][col] = colour;
+            }
+        }
+    }
+
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) override
+    {
+        // As the library does it, two lines across and two down between them
+        fillRect(x, y, w, 1, colour);
+        fillRect(x, y + h - 1, w, 1, colour);
+        fillRect(x, y + 1, 1, h - 2, colour);
+        fillRect(x + w - 1, y + 1, 1, h - 2, colour);
+    }
+
+    void draw16bitBeRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h) override
+    {
+        int16_t cx = x, cy = y, cw = w, ch = h;
+        if (!_clip(&cx, &cy, &cw, &ch)) return;
+
+        m_stats.bitmaps++;
+        m_stats.windows++;
+        m_stats.bus_bytes += WINDOW_BYTES + static_cast<uint32_t>(cw) * ch * 2;
+        for (int16_t row = cy; row < (cy + ch); row++)
+        {
+            for (int16_t col = cx; col < (cx + cw); col++)
+            {
+                uint8_t const *p = reinterpret_cast<uint8_t const *>(&bitmap[(row - y) * w + (col - x)]);
+                m_frame[row][col] = (static_cast<uint16_t>(p[0]) << 8) | p[1];
+            }
+        }
+    }
+
+    /// @brief Fill the whole frame without counting it, e.g. to start a test from a known frame
+    /// @param colour The colour in native order
+    void clear(uint16_t const colour)
+    {
+        for (int16_t row = 0; row < HEIGHT; row++)
+        {
+            for (int16_t col = 0; col < WIDTH; col++)
+            {
+                m_frame[row][col] = colour;
+            }
+        }
+        m_window_w = 0;
+        m_window_h = 0;
+        m_window_pos = 0;
+    }
+
+    /// @brief Get a pixel of the frame
+    /// @return uint16_t: The colour in native order
+    uint16_t pixel(int16_t const x, int16_t const y) const { return m_frame[y][x]; }
+
+    /// @brief Get the primitives counted since the last resetStats
+    panel_stats_t const &stats() const { return m_stats; }
+
+    /// @brief Zero the counters
+    void resetStats() { memset(&m_stats, 0, sizeof(m_stats)); }
+
+    /// @brief Write the frame to a binary PPM file, RGB565 expanded to 8 bits a channel
+    /// @param path The file to write
+    /// @return bool: False if the file couldn't be written
+    bool writePPM(char const *path) const
+    {
+        FILE *file = fopen(path, "wb");
+        if (file == nullptr) return false;
+
+        fprintf(file, "P6\n%d %d\n255\n", WIDTH, HEIGHT);
+        uint8_t line[WIDTH * 3];
+        for (int16_t row = 0; row < HEIGHT; row++)
+        {
+            for (int16_t col = 0; col < WIDTH; col++)
+            {
+                uint16_t const c = m_frame[row][col];
+                uint8_t const r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+                line[col * 3 + 0] = (r << 3) | (r >> 2);
+                line[col * 3 + 1] = (g << 2) | (g >> 4);
+                line[col * 3 + 2] = (b << 3) | (b >> 2);
+            }
+            fwrite(line, 1, sizeof(line), file);
+        }
+        return fclose(file) == 0;
+    }
+
+    /// @brief Compare the frame with a PPM written by writePPM, e.g. a golden image of a screen
+    /// @param path The file to compare with
+    /// @return uint32_t: The number of pixels that differ, or UINT32_MAX if the file can't be read or isn't the
+    /// size of the frame
+    uint32_t diffPPM(char const *path) const
+    {
+        FILE *file = fopen(path, "rb");
+        if (file == nullptr) return UINT32_MAX;
+
+        int w = 0, h = 0, max = 0;
+        if ((fscanf(file, "P6 %d %d %d", &w, &h, &max) != 3) || (w != WIDTH) || (h != HEIGHT) || (max != 255) ||
+            (fgetc(file) == EOF))
+        {
+            fclose(file);
+            return UINT32_MAX;
+        }
+
+        uint32_t diff = 0;
+        uint8_t line[WIDTH * 3];
+        for (int16_t row = 0; row < HEIGHT; row++)
+        {
+            if (fread(line, 1, sizeof(line), file) != sizeof(line))
+            {
+                fclose(file);
+                return UINT32_MAX;
+            }
+            for (int16_t col = 0; col < WIDTH; col++)
+            {
+                uint8_t const *p = &line[col * 3];
+                uint16_t const c = ((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[2] >> 3);
+                if (c != m_frame[row][col]) diff++;
+            }
+        }
+        fclose(file);
+        return diff;
+    }
+
+private:
+    uint16_t m_frame[HEIGHT][WIDTH];
+    panel_stats_t m_stats;
+    int16_t m_window_x, m_window_y;
+    uint16_t m_window_w, m_window_h;
+    uint32_t m_window_pos; ///< Pixels written into the window so far
+
+    /// @brief Put the next pixel of the window, the panel wraps back to the start once the window is full
+    void _windowPixel(uint16_t const colour)
+    {
+        uint32_t const area = static_cast<uint32_t>(m_window_w) * m_window_h;
+        if (area == 0) return;
+
+        int16_t const col = m_window_x + (m_window_pos % m_window_w);
+        int16_t const row = m_window_y + (m_window_pos / m_window_w);
+        if ((col >= 0) && (col < WIDTH) && (row >= 0) && (row < HEIGHT)) m_frame[row][col] = colour;
+        m_window_pos = (m_window_pos + 1) % area;
+    }
+
+    /// @brief Clip a rectangle to the frame
+    /// @return bool: False if nothing is left
+    static bool _clip(int16_t *x, int16_t *y, int16_t *w, int16_t *h)
+    {
+        if (*x < 0)
+        {
+            *w += *x;
+            *x = 0;
+        }
+        if (*y < 0)
+        {
+            *h += *y;
+            *y = 0;
+        }
+        if ((*x + *w) > WIDTH) *w = WIDTH - *x;
+        if ((*y + *h) > HEIGHT) *h = HEIGHT - *y;
+        return (*w > 0) && (*h > 0);
+    }
+};
+
+} // namespace display
+#endif // __PANEL_FRAMEBUFFER_H__
@@ -0,0 +1,218 @@
+/*
+    panel_snapshot.h
+    Description: A panel backend that passes everything on to another panel and also copies it into a file.
+    The file holds one raw RGB565 pixel per screen position, top-down and in wire order, after a header of base bytes.
+    Whatever is drawn while the snapshot panel is in use lands at its place in the file, so drawing a whole screen
+    leaves a copy of it that can later be streamed back in one address window (see display::beginSnapshot).
+    Writes to the same row follow on from each other, a seek is only needed when a window moves to another row.
+    SdFat can't seek past the end of a file, so the file grows as pixels are written in screen order, e.g. by the
+    whole background drawn first. A seek past the end or a write that fails, or anything drawn around the panel,
+    marks the copy as failed and it must not be kept.
+*/
+
+#ifndef __PANEL_SNAPSHOT_H__
+#define __PANEL_SNAPSHOT_H__
+
+#include <SD.h>
+#include "panel.h"
+
+namespace display
+{
+
+class panel_snapshot_c : public panel_abstract_c
+{
+public:
+    /// @brief Pixels of a repeated colour written to the file at a time
+    static uint16_t constexpr REPEAT_CHUNK_PIXELS = 32;
+
+    panel_snapshot_c()
+    : m_panel(nullptr)
+    , m_file(nullptr)
+    , m_base(0)
+    , m_position(0)
+    , m_width(0)
+    , m_height(0)
+    , m_window_x(0)
+    , m_window_y(0)
+    , m_window_w(0)
+    , m_window_h(0)
+    , m_window_pos(0)
+    , m_failed(false)
+    {
+    }
+
+    /// @brief Start copying what is drawn into a file
+    /// @param panel The panel drawn on, it must outlive its use
+    /// @param file The snapshot file, opened for writing without appending, holding just the header
+    /// @param base Where the first pixel goes in the file, after the header
+    void begin(panel_abstract_c *panel, File *file, uint32_t const base)
+    {
+        m_panel = panel;
+        m_file = file;
+        m_base = base;
+        m_position = UINT32_MAX;
+        m_width = panel->width();
+        m_height = panel->height();
+        m_window_w = 0;
+        m_window_h = 0;
+        m_window_pos = 0;
+        m_failed = false;
+    }
+
+    /// @brief Mark the copy as not matching the screen, e.g. when something was drawn without going through panel()
+    void abandon() { m_failed = true; }
+
+    /// @brief Check whether the copy can be kept
+    /// @return bool: True if a seek or write to the file failed, or abandon was called, since begin
+    bool failed() const { return m_failed; }
+
+    /// @brief Get the panel being drawn on
+    /// @return panel_abstract_c*: The panel given to begin
+    panel_abstract_c *panel() const { return m_panel; }
+
+    int16_t width() override { return m_width; }
+    int16_t height() override { return m_height; }
+    void startWrite() override { m_panel->startWrite(); }
+    void endWrite() override { m_panel->endWrite(); }
+
+    void writeAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) override
+    {
+        m_panel->writeAddrWindow(x, y, w, h);
+        m_window_x = x;
+        m_window_y = y;
+        m_window_w = w;
+        m_window_h = h;
+        m_window_pos = 0;
+    }
+
+    void writeBytes(uint8_t *data, uint32_t len) override
+    {
+        m_panel->writeBytes(data, len);
+        _windowPixels(data, len / 2);
+    }
+
+    void writeRepeat(uint16_t colour, uint32_t len) override
+    {
+        m_panel->writeRepeat(colour, len);
+
+        uint16_t chunk[REPEAT_CHUNK_PIXELS];
+        _fillChunk(chunk, colour);
+        while (len > 0)
+        {
+            uint16_t const count = (len < REPEAT_CHUNK_PIXELS) ? len : REPEAT_CHUNK_PIXELS;
+            _windowPixels(reinterpret_cast<uint8_t const *>(chunk), count);
+            len -= count;
+        }
+    }
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) override
+    {
+        m_panel->fillRect(x, y, w, h, colour);
+        _storeRect(x, y, w, h, colour);
+    }
+
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) override
+    {
+        m_panel->drawRect(x, y, w, h, colour);
+        _storeRect(x, y, w, 1, colour);
+        _storeRect(x, y + h - 1, w, 1, colour);
+        _storeRect(x, y + 1, 1, h - 2, colour);
+        _storeRect(x + w - 1, y + 1, 1, h - 2, colour);
+    }
+
+    void draw16bitBeRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h) override
+    {
+        m_panel->draw16bitBeRGBBitmap(x, y, bitmap, w, h);
+        if (w <= 0) return;
+        for (int16_t row = 0; row < h; row++)
+        {
+            _store(x, y + row, reinterpret_cast<uint8_t const *>(&bitmap[static_cast<int32_t>(row) * w]), w);
+        }
+    }
+
+private:
+    panel_abstract_c *m_panel;
+    File *m_file;
+    uint32_t m_base;
+    uint32_t m_position; ///< Where the file is, UINT32_MAX if unknown
+    int16_t m_width, m_height;
+    int16_t m_window_x, m_window_y;
+    uint16_t m_window_w, m_window_h;
+    uint32_t m_window_pos; ///< Pixels written into the window so far
+    bool m_failed;
+
+    /// @brief Fill a chunk with a colour in wire order
+    static void _fillChunk(uint16_t *chunk, uint16_t const colour)
+    {
+        uint8_t *bytes = reinterpret_cast<uint8_t *>(chunk);
+        for (uint16_t i = 0; i < REPEAT_CHUNK_PIXELS; i++)
+        {
+            bytes[i * 2] = colour >> 8;
+            bytes[i * 2 + 1] = colour & 0xFF;
+        }
+    }
+
+    /// @brief Copy pixels sent to the window into the file, a row of the window at a time
+    /// @param data The pixels in wire order
+    /// @param count The number of pixels
+    void _windowPixels(uint8_t const *data, uint32_t count)
+    {
+        uint32_t const area = static_cast<uint32_t>(m_window_w) * m_window_h;
+        if (area == 0) return;
+
+        while (count > 0)
+        {
+            uint16_t const col = m_window_pos % m_window_w;
+            uint16_t const row = m_window_pos / m_window_w;
+            uint16_t const row_left = m_window_w - col;
+            uint16_t const span = (count < row_left) ? count : row_left;
+
+            _store(m_window_x + col, m_window_y + row, data, span);
+            data += span * 2;
+            count -= span;
+            m_window_pos = (m_window_pos + span) % area; // the panel wraps back to the start once the window is full
+        }
+    }
+
+    /// @brief Copy a rectangle of one colour into the file
+    void _storeRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t const colour)
+    {
+        uint16_t chunk[REPEAT_CHUNK_PIXELS];
+        _fillChunk(chunk, colour);
+        for (int16_t row = y; row < (y + h); row++)
+        {
+            for (int16_t col = x; col < (x + w); col += REPEAT_CHUNK_PIXELS)
+            {
+                int16_t const count = ((x + w - col) < REPEAT_CHUNK_PIXELS) ? (x + w - col) : REPEAT_CHUNK_PIXELS;
+                _store(col, row, reinterpret_cast<uint8_t const *>(chunk), count);
+            }
+        }
+    }
+
+    /// @brief Copy part of a row into the file, clipped to the screen
+    /// @param data The pixels in wire order
+    void _store(int16_t x, int16_t const y, uint8_t const *data, int16_t count)
+    {
+        if ((y < 0) || (y >= m_height)) return;
+        if (x < 0)
+        {
+            data += static_cast<int32_t>(-x) * 2;
+            count += x;
+            x = 0;
+        }
+        if ((x + count) > m_width) count = m_width - x;
+        if ((count <= 0) || m_failed) return;
+
+        uint32_t const offset = m_base + (static_cast<uint32_t>(y) * m_width + x) * 2;
+        size_t const bytes = static_cast<size_t>(count) * 2;
+        if (((offset != m_position) && !m_file->seek(offset)) || (m_file->write(data, bytes) != bytes))
+        {
+            m_failed = true;
+            return;
+        }
+        m_position = offset + bytes;
+    }
+};
+
+} // namespace display
+#endif // __PANEL_SNAPSHOT_H__
@@ -67,9 +67,10 @@ public:
         return m_model->queryMacros(ids, names);
     }
 
-    size_t handleGetMacroOptions(size_t const qty, uint16_t *ids, String *names, uint16_t const start = 0)
+    size_t handleGetMacroOptions(
+        size_t const qty, uint16_t *ids, String *names, uint16_t const start = 0, String *images = nullptr)
     {
-        return m_model->getMacroOptions(qty, ids, names, start);
+        return m_model->getMacroOptions(qty, ids, names, start, images);
     }
 
     void handleMinMaxID(uint16_t *min_id, uint16_t *max_id)
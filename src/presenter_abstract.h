@@ -18,7 +18,7 @@ class presenter_abstract_c
 public:
     virtual size_t handleQueryMacros(uint16_t *, String *) = 0;
     virtual size_t handleLoadMacros(uint16_t const *, size_t const, String *, String *, macro::macro_c *) = 0;
-    virtual size_t handleGetMacroOptions(size_t const, uint16_t *, String *, uint16_t const = 0) = 0;
+    virtual size_t handleGetMacroOptions(size_t const, uint16_t *, String *, uint16_t const = 0, String * = nullptr) = 0;
     virtual void handleMinMaxID(uint16_t *, uint16_t *) = 0;
     virtual int16_t handleGetMacroCount() = 0;
 };
@@ -0,0 +1,143 @@
+/*
+    render_timing.h
+    Description: Stage timers for finding where drawing time goes, compiled out unless RENDER_TIMING is defined below.
+    Put a scope_c at the top of a block to add its time to a stage. Each stage keeps a count, a total and a maximum,
+    printed by dump(). With RENDER_TIMING defined, send 't' over Serial to dump and reset them.
+    Stages nest, e.g. a screen's time includes the reads, conversions and bus writes done while drawing it.
+*/
+
+#ifndef __RENDER_TIMING_H__
+#define __RENDER_TIMING_H__
+
+#include <Arduino.h>
+
+// To time the drawing stages, define RENDER_TIMING below. Define it here rather than in macro-pad.ino: the Arduino IDE
+// compiles the sketch and each file in src separately, and a define in the sketch never reaches the drawing code.
+// #define RENDER_TIMING
+
+namespace render_timing
+{
+
+/// @brief The stages timed
+enum class stage_t : uint8_t
+{
+    SD_OPEN = 0, ///< Opening image files
+    SD_READ, ///< Reading image data
+    CONVERT, ///< Converting lines to RGB565
+    BUS, ///< Sending decoded pixels to the display
+    TEXT, ///< Laying out and drawing text
+    DRAW_IMAGE, ///< display::drawImage, from open to close
+    SCREEN_HOME, ///< view_c::homeScreen
+    SCREEN_MENU, ///< view_c::mainMenu
+    SCREEN_MACRO_SELECT, ///< view_c::macroSelect
+    SCREEN_MACRO_PLACE, ///< view_c::macroPlace
+    COUNT
+};
+
+/// @brief Times collected for one stage
+struct stat_t
+{
+    uint32_t count;
+    uint32_t total_us;
+    uint32_t max_us;
+};
+
+#if defined(RENDER_TIMING)
+
+/// @brief Get the table of times, one per stage
+/// @return stat_t*: The times, indexed by stage_t
+inline stat_t *stats()
+{
+    static stat_t table[static_cast<uint8_t>(stage_t::COUNT)] = {};
+    return table;
+}
+
+/// @brief Add a time to a stage
+/// @param stage The stage
+/// @param us The time in microseconds
+inline void record(stage_t const stage, uint32_t const us)
+{
+    stat_t &stat = stats()[static_cast<uint8_t>(stage)];
+    stat.count++;
+    stat.total_us += us;
+    if (us > stat.max_us) stat.max_us = us;
+}
+
+/// @brief Clear every stage's times
+inline void reset()
+{
+    memset(stats(), 0, sizeof(stat_t) * static_cast<uint8_t>(stage_t::COUNT));
+}
+
+/// @brief Print every stage's count, total and maximum over Serial
+inline void dump()
+{
+    static char const *const NAMES[] = {
+        "sd open", "sd read", "convert", "bus", "text", "draw image",
+        "home screen", "main menu", "macro select", "macro place"};
+    static_assert(sizeof(NAMES) / sizeof(NAMES[0]) == static_cast<uint8_t>(stage_t::COUNT), "a stage has no name");
+
+    Serial.println("stage, count, total us, max us");
+    for (uint8_t i = 0; i < static_cast<uint8_t>(stage_t::COUNT); i++)
+    {
+        stat_t const &stat = stats()[i];
+        Serial.print(NAMES[i]);
+        Serial.print(", ");
+        Serial.print(stat.count);
+        Serial.print(", ");
+        Serial.print(stat.total_us);
+        Serial.print(", ");
+        Serial.println(stat.max_us);
+    }
+}
+
+/// @brief Dump and reset the times if 't' has been sent over Serial
+inline void poll()
+{
+    while (Serial.available() > 0)
+    {
+        if (Serial.read() == 't')
+        {
+            dump();
+            reset();
+        }
+    }
+}
+
+/// @brief Times the block it is declared in and adds the time to a stage when the block ends
+class scope_c
+{
+public:
+    explicit scope_c(stage_t const stage)
+    : m_stage(stage)
+    , m_start(micros())
+    {
+    }
+
+    ~scope_c()
+    {
+        record(m_stage, micros() - m_start);
+    }
+
+private:
+    stage_t m_stage;
+    uint32_t m_start;
+};
+
+#else
+
+// Compiled out, the calls are left in place and cost nothing
+inline void reset() {}
+inline void dump() {}
+inline void poll() {}
+
+class scope_c
+{
+public:
+    explicit scope_c(stage_t const) {}
+};
+
+#endif // RENDER_TIMING
+
+} // namespace render_timing
+#endif // __RENDER_TIMING_H__
@@ -0,0 +1,121 @@
+/*
+    rgb565.h
+    Description: Conversion of 24 and 32-bit pixels to the display's RGB565 format.
+    The 24-bit kernel converts four pixels (twelve bytes) per iteration from three 32-bit loads, instead of three
+    byte loads and a multiply per pixel. Both the Cortex-M4 and a PC are little-endian and allow unaligned loads, so
+    the loads go through memcpy, which compiles to a single load on both.
+
+    The display is sent the high byte of each pixel first. Line conversions can write that wire order directly, so
+    the pixels can be sent as raw bytes without being swapped again on the way out.
+*/
+
+#ifndef __RGB565_H__
+#define __RGB565_H__
+
+#include <Arduino.h>
+
+namespace rgb565
+{
+
+/// @brief Magenta, pixels of this colour are left undrawn when an image is drawn with transparency
+uint16_t constexpr COLOUR_KEY = 0xF81F;
+
+/// @brief Convert one pixel to RGB565
+/// @param r Red
+/// @param g Green
+/// @param b Blue
+/// @return uint16_t: The RGB565 colour
+inline uint16_t fromRGB(uint8_t const r, uint8_t const g, uint8_t const b)
+{
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+/// @brief Swap a pixel between native and wire (most significant byte first) order
+/// @param colour The pixel
+/// @return uint16_t: The pixel with its bytes swapped
+inline uint16_t swap(uint16_t const colour)
+{
+    return __builtin_bswap16(colour);
+}
+
+/// @brief Load four bytes as a little-endian word
+inline uint32_t loadWord(uint8_t const *src)
+{
+    uint32_t word;
+    memcpy(&word, src, sizeof(word));
+    return word;
+}
+
+/// @brief Convert a line of 24-bit pixels, stored blue, green, red as in a BMP
+/// @param src The pixels, three bytes each
+/// @param dst The converted pixels
+/// @param count The number of pixels to convert
+/// @param wire_order Write the pixels in wire order (default: false, native order)
+inline void fromBGR24(uint8_t const *src, uint16_t *dst, uint32_t count, bool const wire_order = false)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    // Four pixels span three words, shown most significant byte first:
+    //   w0 = [B1 R0 G0 B0]
+    //   w1 = [G2 B2 R1 G1]
+    //   w2 = [R3 G3 B3 R2]
+    for (; count >= 4; count -= 4)
+    {
+        uint32_t const w0 = loadWord(src);
+        uint32_t const w1 = loadWord(src + 4);
+        uint32_t const w2 = loadWord(src + 8);
+
+        uint16_t const p0 = ((w0 >> 8) & 0xF800) | ((w0 >> 5) & 0x07E0) | ((w0 >> 3) & 0x001F);
+        uint16_t const p1 = (w1 & 0xF800) | ((w1 << 3) & 0x07E0) | (w0 >> 27);
+        uint16_t const p2 = ((w2 << 8) & 0xF800) | ((w1 >> 21) & 0x07E0) | ((w1 >> 19) & 0x001F);
+        uint16_t const p3 = ((w2 >> 16) & 0xF800) | ((w2 >> 13) & 0x07E0) | ((w2 >> 11) & 0x001F);
+
+        if (wire_order)
+        {
+            dst[0] = swap(p0);
+            dst[1] = swap(p1);
+            dst[2] = swap(p2);
+            dst[3] = swap(p3);
+        }
+        else
+        {
+            dst[0] = p0;
+            dst[1] = p1;
+            dst[2] = p2;
+            dst[3] = p3;
+        }
+
+        src += 12;
+        dst += 4;
+    }
+#endif
+
+    for (; count > 0; count--)
+    {
+        uint16_t const colour = fromRGB(src[2], src[1], src[0]);
+        *dst++ = wire_order ? swap(colour) : colour;
+        src += 3;
+    }
+}
+
+/// @brief Convert a line of 32-bit pixels, stored blue, green, red, alpha as in a BMP (alpha is ignored)
+/// @param src The pixels, four bytes each
+/// @param dst The converted pixels
+/// @param count The number of pixels to convert
+/// @param wire_order Write the pixels in wire order (default: false, native order)
+inline void fromBGRA32(uint8_t const *src, uint16_t *dst, uint32_t count, bool const wire_order = false)
+{
+    for (; count > 0; count--)
+    {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+        uint32_t const w = loadWord(src); // [A R G B]
+        uint16_t const colour = ((w >> 8) & 0xF800) | ((w >> 5) & 0x07E0) | ((w >> 3) & 0x001F);
+#else
+        uint16_t const colour = fromRGB(src[2], src[1], src[0]);
+#endif
+        *dst++ = wire_order ? swap(colour) : colour;
+        src += 4;
+    }
+}
+
+} // namespace rgb565
+#endif // __RGB565_H__
@@ -0,0 +1,76 @@
+/*
+    rle.h
+    Description: Run-length encoded RGB565 images (".rle"), written by tools/bmp_tool.py.
+    Flat areas are stored once with a repeat count, so they cost three bytes on the card and a single repeated
+    colour on the display bus, however long the run is.
+
+    Layout:
+        header_t
+        uint32_t row_offsets[height]    File offset of the first packet of each row, top row first
+        packets                         Rows top-down, a packet never crosses the end of a row
+
+    Each packet starts with a control byte. If the top bit is set, the low 7 bits + 1 is the length of a run and a
+    single colour follows. Otherwise the low 7 bits + 1 is the number of literal colours that follow.
+    Colours are RGB565, most significant byte first, the order they are sent to the display, so literals are written
+    to the bus straight from the read buffer.
+*/
+
+#ifndef __RLE_H__
+#define __RLE_H__
+
+#include <SD.h>
+
+namespace rle
+{
+
+/// @brief Bump when the layout changes, older files are then refused rather than drawn wrongly
+/// @note Version 2 stores colours most significant byte first
+uint8_t constexpr VERSION = 2;
+
+/// @brief Set in a control byte for a run, clear for literals
+uint8_t constexpr RUN_FLAG = 0x80;
+
+/// @brief Longest run or literal a single packet can hold
+uint8_t constexpr MAX_PACKET_PIXELS = 128;
+
+/// @brief Header at the start of every RLE image
+struct header_t
+{
+    uint8_t magic[4];
+    uint8_t version;
+    uint8_t flags; ///< Reserved
+    uint16_t width;
+    uint16_t height;
+    uint16_t reserved;
+};
+
+/// @brief Read and validate the header of an RLE image
+/// @param f The image file
+/// @param header The header read from the file
+/// @param base Where the image starts in the file, non-zero when it is stored inside an icon pack (default: 0)
+/// @return bool: True if the file is an RLE image this version can draw
+inline bool readHeader(File *f, header_t *header, uint32_t const base = 0)
+{
+    f->seek(base);
+    if (f->read(reinterpret_cast<uint8_t *>(header), sizeof(header_t)) != sizeof(header_t)) return false;
+
+    return (header->magic[0] == 'R') && (header->magic[1] == 'L') && (header->magic[2] == 'E') &&
+           (header->magic[3] == '5') && (header->version == VERSION) && (header->width > 0) && (header->height > 0);
+}
+
+/// @brief Look up where a row's packets start
+/// @param f The image file
+/// @param row The row, counted from the top of the image
+/// @param base Where the image starts in the file (default: 0)
+/// @return uint32_t: The file offset of the row's first packet
+/// @note Offsets in the table are relative to the start of the image
+inline uint32_t rowOffset(File *f, uint16_t const row, uint32_t const base = 0)
+{
+    uint32_t offset = 0;
+    f->seek(base + sizeof(header_t) + static_cast<uint32_t>(row) * sizeof(uint32_t));
+    f->read(reinterpret_cast<uint8_t *>(&offset), sizeof(offset));
+    return base + offset;
+}
+
+} // namespace rle
+#endif // __RLE_H__
@@ -0,0 +1,137 @@
+/*
+    scene.h
+    Description: Retained description of the widgets currently on the display.
+    Every widget the view draws is recorded with its geometry, colours, label and image. When a screen is drawn, each
+    widget is compared with what the display already shows at that rectangle, and only widgets that differ are drawn.
+    Anything that paints over the display outside of a widget draw (background restores, messages) must forget the
+    widgets it touches, see forget() and clear().
+*/
+
+#ifndef __SCENE_H__
+#define __SCENE_H__
+
+#include <Arduino.h>
+#include "wireframe.h"
+
+namespace gui
+{
+
+/// @brief Everything that decides how a widget looks
+struct widget_t
+{
+    wf_element_t rect;
+    uint16_t fill_colour;
+    uint16_t text_colour;
+    uint16_t border_colour;
+    uint32_t label_hash; ///< See scene_c::hash
+    uint32_t image_hash; ///< 0 for widgets without an image
+};
+
+class scene_c
+{
+public:
+    /// @brief Most widgets remembered, widgets past this are always drawn
+    static size_t constexpr MAX_WIDGETS = 24;
+
+    /// @brief Constructor
+    scene_c()
+    : m_count(0)
+    , m_drawn(0)
+    , m_skipped(0)
+    {
+    }
+
+    /// @brief Check if a widget needs drawing, and record it as drawn if it does
+    /// @param widget The widget about to be drawn
+    /// @return bool: False if the display already shows exactly this widget, nothing needs sending
+    bool update(widget_t const &widget)
+    {
+        for (size_t i = 0; i < m_count; i++)
+        {
+            if (_same(m_widgets[i], widget))
+            {
+                m_skipped++;
+                return false;
+            }
+        }
+
+        // The new widget replaces whatever it overlaps
+        forget(widget.rect);
+        if (m_count < MAX_WIDGETS) m_widgets[m_count++] = widget;
+        m_drawn++;
+        return true;
+    }
+
+    /// @brief Check if the display already shows a widget, without recording anything
+    /// @param widget The widget
+    /// @return bool: True if update would skip it
+    bool shown(widget_t const &widget) const
+    {
+        for (size_t i = 0; i < m_count; i++)
+        {
+            if (_same(m_widgets[i], widget)) return true;
+        }
+        return false;
+    }
+
+    /// @brief Forget every widget overlapping a rectangle that has been drawn over
+    /// @param rect The rectangle
+    void forget(wf_element_t const &rect)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < m_count; i++)
+        {
+            if (!_overlaps(m_widgets[i].rect, rect)) m_widgets[kept++] = m_widgets[i];
+        }
+        m_count = kept;
+    }
+
+    /// @brief Forget every widget, e.g. after the whole screen has been drawn over
+    void clear() { m_count = 0; }
+
+    /// @brief Get the number of widgets drawn
+    /// @return uint32_t: Widgets that differed from the display
+    uint32_t drawn() const { return m_drawn; }
+
+    /// @brief Get the number of draws avoided
+    /// @return uint32_t: Widgets the display already showed
+    uint32_t skipped() const { return m_skipped; }
+
+    /// @brief Hash a label or image path for widget_t
+    /// @param text The text
+    /// @return uint32_t: FNV-1a hash of the text, 0 for an empty string
+    static uint32_t hash(String const &text)
+    {
+        if (text.length() == 0) return 0;
+
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < text.length(); i++)
+        {
+            h = (h ^ static_cast<uint8_t>(text[i])) * 16777619u;
+        }
+        return h;
+    }
+
+private:
+    widget_t m_widgets[MAX_WIDGETS];
+    size_t m_count;
+    uint32_t m_drawn;
+    uint32_t m_skipped;
+
+    static bool _same(widget_t const &a, widget_t const &b)
+    {
+        return (a.rect.x == b.rect.x) && (a.rect.y == b.rect.y) && (a.rect.width == b.rect.width) &&
+               (a.rect.height == b.rect.height) && (a.fill_colour == b.fill_colour) &&
+               (a.text_colour == b.text_colour) && (a.border_colour == b.border_colour) &&
+               (a.label_hash == b.label_hash) && (a.image_hash == b.image_hash);
+    }
+
+    static bool _overlaps(wf_element_t const &a, wf_element_t const &b)
+    {
+        return (a.x < (b.x + b.width)) && (b.x < (a.x + a.width)) && (a.y < (b.y + b.height)) &&
+               (b.y < (a.y + a.height));
+    }
+};
+
+} // namespace gui
+#endif // __SCENE_H__
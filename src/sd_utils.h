@@ -22,7 +22,7 @@ inline bool initialiseSD()
 /// @return String: The line
 inline String readLineUntil(File *file, char delim = ',')
 {
-    char buffer[250] = {NULL};
+    char buffer[250] = {};
     size_t idx = 0;
     while (file->peek() != delim && file->available())
     {
@@ -52,5 +52,65 @@ inline String readLine(File *file)
     return readLineUntil(file, '\n');
 }
 
+/// @brief Reads a file forwards through a small buffer, so byte-sized reads don't each go through the SD library
+class buffered_reader_c
+{
+public:
+    /// @brief Constructor
+    /// @param file The file to read, reading starts from its current position
+    buffered_reader_c(File *file)
+    : m_file(file)
+    , m_pos(0)
+    , m_len(0)
+    {
+    }
+
+    /// @brief Read the next byte
+    /// @return int: The byte, or -1 at the end of the file
+    int read()
+    {
+        if (m_pos == m_len && !_fill()) return -1;
+        return m_buffer[m_pos++];
+    }
+
+    /// @brief Read the next bytes
+    /// @param dst Where to copy the bytes
+    /// @param count The number of bytes to read
+    /// @return size_t: The number of bytes read, less than count at the end of the file
+    size_t read(uint8_t *dst, size_t count)
+    {
+        size_t done = 0;
+        while (done < count)
+        {
+            if (m_pos == m_len && !_fill()) break;
+
+            size_t chunk = m_len - m_pos;
+            if (chunk > count - done) chunk = count - done;
+            memcpy(dst + done, m_buffer + m_pos, chunk);
+            m_pos += chunk;
+            done += chunk;
+        }
+        return done;
+    }
+
+private:
+    static size_t constexpr BUFFER_SIZE = 128;
+
+    File *m_file;
+    uint8_t m_buffer[BUFFER_SIZE];
+    size_t m_pos;
+    size_t m_len;
+
+    /// @brief Refill the buffer from the file
+    /// @return bool: False at the end of the file
+    bool _fill()
+    {
+        int const got = m_file->read(m_buffer, sizeof(m_buffer));
+        m_pos = 0;
+        m_len = (got > 0) ? got : 0;
+        return m_len > 0;
+    }
+};
+
 } // namespace sd
 #endif // __SD_UTILS_H__
\ No newline at end of file
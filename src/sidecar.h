@@ -0,0 +1,129 @@
+/*
+    sidecar.h
+    Description: Raw RGB565 sidecar files for decoded bitmaps.
+    The first full draw of a 24-bit BMP writes the converted pixels next to the source (e.g. "/bckgrnd.bmp" ->
+    "/bckgrnd.565"). Later draws stream the sidecar straight to the display, skipping the per-pixel conversion and
+    reading two bytes per pixel instead of three.
+*/
+
+#ifndef __SIDECAR_H__
+#define __SIDECAR_H__
+
+#include <SD.h>
+
+namespace sidecar
+{
+
+/// @brief Bump when the layout of the header or the pixel data changes, stale sidecars are then rebuilt
+/// @note Version 2 added FLAG_WIRE_ORDER and stores rows top-down. Version 1 sidecars, native order and possibly
+/// bottom-up (flag 0x01), fail readHeader and are rebuilt.
+uint8_t constexpr VERSION = 2;
+
+/// @brief Pixels are stored most significant byte first, the order they are sent to the display
+uint8_t constexpr FLAG_WIRE_ORDER = 0x02;
+
+/// @brief Number of evenly spaced samples of the source file mixed into the source key
+uint8_t constexpr KEY_SAMPLES = 8;
+
+/// @brief Number of bytes read for each sample of the source file
+uint8_t constexpr KEY_SAMPLE_BYTES = 32;
+
+/// @brief Header at the start of every sidecar file, followed by width * height RGB565 pixels, rows top-down
+struct header_t
+{
+    uint8_t magic[4];
+    uint8_t version;
+    uint8_t flags;
+    uint16_t width;
+    uint16_t height;
+    uint16_t reserved;
+    uint32_t source_size; ///< Size of the source BMP when the sidecar was written
+    uint32_t source_key; ///< See sourceKey()
+};
+
+/// @brief Get the sidecar path for a given image
+/// @param image_path The path of the source image, e.g. "/icons/A_FLA039.bmp"
+/// @return String: The path of the sidecar, e.g. "/icons/A_FLA039.565"
+inline String pathFor(String const &image_path)
+{
+    int const dot = image_path.lastIndexOf('.');
+    if (dot < 0) return image_path + ".565";
+    return image_path.substring(0, dot) + ".565";
+}
+
+/// @brief Fingerprint the source file so an edited image invalidates its sidecar
+/// @param f The source file
+/// @return uint32_t: FNV-1a hash of the file size and evenly spaced samples of its content
+/// @note The SD library does not expose file timestamps, so a sampled content hash stands in for one. An edit that
+/// keeps the file size and misses every sample is not detected, delete the ".565" file to force a rebuild.
+inline uint32_t sourceKey(File *f)
+{
+    uint32_t hash = 2166136261UL;
+    uint32_t const size = f->size();
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        hash = (hash ^ ((size >> (i * 8)) & 0xFF)) * 16777619UL;
+    }
+
+    uint8_t sample[KEY_SAMPLE_BYTES];
+    for (uint8_t i = 0; i < KEY_SAMPLES; i++)
+    {
+        f->seek((size / KEY_SAMPLES) * i);
+        int const count = f->read(sample, sizeof(sample));
+        for (int j = 0; j < count; j++)
+        {
+            hash = (hash ^ sample[j]) * 16777619UL;
+        }
+    }
+
+    return hash;
+}
+
+/// @brief Write the sidecar header, the pixel rows must be written straight after
+/// @param f The sidecar file, opened for writing
+/// @param width The width of the image in pixels
+/// @param height The height of the image in pixels
+/// @param flags Byte order flags, see FLAG_WIRE_ORDER
+/// @param source_size The size of the source file
+/// @param source_key The key of the source file (see sourceKey())
+inline void writeHeader(
+    File *f,
+    uint16_t const width,
+    uint16_t const height,
+    uint8_t const flags,
+    uint32_t const source_size,
+    uint32_t const source_key
+)
+{
+    header_t header = {{'R', '5', '6', '5'}, VERSION, flags, width, height, 0, source_size, source_key};
+    f->write(reinterpret_cast<uint8_t const *>(&header), sizeof(header));
+}
+
+/// @brief Read the header of a sidecar and check it is complete and matches the source file
+/// @param f The sidecar file
+/// @param header The header read from the file
+/// @param source_size The current size of the source file
+/// @param source_key The current key of the source file (see sourceKey())
+/// @return bool: True if the sidecar can be drawn in place of the source
+inline bool readHeader(File *f, header_t *header, uint32_t const source_size, uint32_t const source_key)
+{
+    f->seek(0);
+    if (f->read(reinterpret_cast<uint8_t *>(header), sizeof(header_t)) != sizeof(header_t)) return false;
+
+    if (header->magic[0] != 'R' || header->magic[1] != '5' || header->magic[2] != '6' || header->magic[3] != '5')
+    {
+        return false;
+    }
+
+    // A short file means the write was interrupted
+    uint32_t const expected_size = sizeof(header_t) + static_cast<uint32_t>(header->width) * header->height * 2;
+
+    return (header->version == VERSION)
+        && (header->source_size == source_size)
+        && (header->source_key == source_key)
+        && (f->size() == expected_size);
+}
+
+} // namespace sidecar
+#endif // __SIDECAR_H__
@@ -0,0 +1,112 @@
+/*
+    text_layout.h
+    Description: Word wrapping for text drawn in the default GFX font.
+    Lines are recorded as index ranges into the original text, so laying out a label needs no heap and the result
+    is small enough to keep with the button it belongs to. A layout is only valid for the width and text size it was
+    made for, see layout_t::valid.
+*/
+
+#ifndef __TEXT_LAYOUT_H__
+#define __TEXT_LAYOUT_H__
+
+#include <Arduino.h>
+
+namespace text_layout
+{
+
+/// @brief Most lines kept in a layout, any more would not fit in a button
+uint8_t constexpr MAX_LINES = 8;
+
+/// @brief Width of a character of the default font at text size 1, including the gap after it
+uint8_t constexpr FONT_WIDTH = 6;
+
+/// @brief Height of a character of the default font at text size 1
+uint8_t constexpr FONT_HEIGHT = 8;
+
+/// @brief One line of wrapped text
+struct line_t
+{
+    uint16_t start; ///< Index of the line's first character in the text
+    uint8_t length; ///< Characters in the line, trailing spaces excluded
+};
+
+/// @brief Line breaks of a piece of text
+struct layout_t
+{
+    line_t lines[MAX_LINES];
+    uint8_t count; ///< Number of lines
+    uint8_t text_size; ///< Text size the layout was made for, 0 if there is no layout
+    int16_t width; ///< Width in pixels the layout was made for
+
+    /// @brief Check if the layout can be used to draw at a width and text size
+    /// @param w The width in pixels
+    /// @param size The text size
+    /// @return bool: True if the layout was made for the same width and size
+    bool valid(int16_t const w, uint8_t const size) const
+    {
+        return (text_size != 0) && (text_size == size) && (width == w);
+    }
+
+    /// @brief Throw the layout away, e.g. when the text changes
+    void invalidate() { text_size = 0; }
+};
+
+/// @brief Wrap text to a width, breaking only between words
+/// @param text The text, spaces separate words and '\n' starts a new line
+/// @param width The width to wrap to in pixels
+/// @param text_size The GFX text size
+/// @param layout The resulting line breaks
+/// @note A word longer than a line is left on a line of its own. Lines past MAX_LINES are dropped.
+/// @note text_size must be at least 1
+inline void wrap(char const *text, int16_t const width, uint8_t const text_size, layout_t *layout)
+{
+    uint16_t const max_chars = width / (FONT_WIDTH * text_size);
+
+    layout->count = 0;
+    layout->text_size = text_size;
+    layout->width = width;
+
+    uint16_t line_start = 0;
+    uint16_t line_end = 0; // end of the last word on the line
+    uint16_t i = 0;
+    for (;;)
+    {
+        uint16_t const word_start = i;
+        while ((text[i] != '\0') && (text[i] != ' ') && (text[i] != '\n'))
+        {
+            i++;
+        }
+
+        // The word and the spaces before it must fit after what is already on the line
+        if ((i > word_start) && (line_end > line_start) && ((i - line_start) > max_chars))
+        {
+            if (layout->count < MAX_LINES)
+            {
+                layout->lines[layout->count++] = {line_start, static_cast<uint8_t>(line_end - line_start)};
+            }
+            line_start = word_start;
+        }
+        if (i > word_start) line_end = i;
+
+        if ((text[i] == '\0') || (text[i] == '\n'))
+        {
+            // A '\n' always ends a line, even an empty one
+            if (((line_end > line_start) || (text[i] == '\n')) && (layout->count < MAX_LINES))
+            {
+                layout->lines[layout->count++] = {line_start, static_cast<uint8_t>(line_end - line_start)};
+            }
+            if (text[i] == '\0') break;
+            line_start = i + 1;
+            line_end = line_start;
+        }
+        else if (line_end == line_start)
+        {
+            line_start = i + 1; // leading spaces aren't drawn
+            line_end = line_start;
+        }
+        i++;
+    }
+}
+
+} // namespace text_layout
+#endif // __TEXT_LAYOUT_H__
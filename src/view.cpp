@@ -6,9 +6,23 @@
 
 #include "view.h"
 
+#if defined(DEBUG)
+#include <unistd.h>
+#endif
+
 namespace view
 {
 
+#if defined(DEBUG)
+/// @brief Get the RAM left between the top of the heap and the stack, for tuning BG_CACHE_BYTES
+/// @return int32_t: The free bytes
+static int32_t freeRam()
+{
+    char stack_top;
+    return &stack_top - reinterpret_cast<char *>(sbrk(0));
+}
+#endif
+
 view_c::view_c()
 : m_state(view_state_t::NONE)
 , m_prev_state(view_state_t::NONE)
@@ -16,6 +30,15 @@ view_c::view_c()
 , m_current_selected_placement(UCHAR_MAX)
 , m_update_macros(false)
 , m_scroll(0)
+, m_touch_pending(false)
+, m_awaiting_release(false)
+, m_frame_incomplete(false)
+, m_thumbnail_spent_us(0)
+, m_thumbnails_deferred(false)
+#if defined(DEBUG)
+, m_burst_start_ms(0)
+, m_frames_dropped(0)
+#endif
 {
     for (size_t i = 0; i < MACRO_BTN_COUNT(m_active_macros); i++)
     {
@@ -37,6 +60,9 @@ view_c::view_c()
         m_macro_placement_options[i] = nullptr;
     }
 
+    // Prefer the run-length encoded background when there is one
+    m_background_image = SD.exists("/bckgrnd.rle") ? "/bckgrnd.rle" : "/bckgrnd.bmp";
+
     /// Load the active macros list
     for (size_t i = 0; i < MACRO_PLACE_OPTIONS; i++)
     {
@@ -56,13 +82,17 @@ view_c::~view_c()
 
 void view_c::clearScreen()
 {
-    display::tft_c::instance().fillScreen(INDIGO_DYE);
+    display::panel().fillRect(0, 0, display::panel().width(), display::panel().height(), INDIGO_DYE);
+    m_damage.add({0, 0, display::panel().width(), display::panel().height()});
+    m_scene.clear();
 }
 
 void view_c::displayMessage(char const *message)
 {
     display::tft_c::instance().fillScreen(INDIGO_DYE);
     display::displayMessage(message);
+    m_damage.add({0, 0, display::tft_c::instance().width(), display::tft_c::instance().height()});
+    m_scene.clear();
 }
 
 void view_c::run()
@@ -74,7 +104,7 @@ void view_c::run()
     String macro_file_paths[num_active_macros_list];
     macro::macro_c macros[num_active_macros_list];
 
-    size_t count = m_presenter->handleLoadMacros(
+    m_presenter->handleLoadMacros(
         m_active_macros_list, num_active_macros_list, macro_names, macro_file_paths, macros);
     createHomeScreenMacroButtons(macros, macro_names, macro_file_paths);
 
@@ -84,58 +114,51 @@ void view_c::run()
     {
         TSPoint tp;
 
-        if (touched(&tp))
+        if (_takeTouch(&tp))
         {
+#if defined(DEBUG)
+            if (m_burst_start_ms == 0) m_burst_start_ms = millis();
+#endif
             _handleTouch(tp);
+#if defined(DEBUG)
+            if (!m_frame_incomplete) m_burst_start_ms = 0; // the touch didn't draw a screen
+#endif
         }
+        else if (m_frame_incomplete)
+        {
+            // The touch that interrupted the frame didn't start a new one
+            _drawScreen();
+        }
+
+        render_timing::poll();
     };
 }
 
 void view_c::loadScreen()
 {
     m_state = view_state_t::LOADING;
-    display::tft_c::instance().fillScreen(INDIGO_DYE);
-    display::drawBmp("/bckgrnd.bmp", 0, 0, display::tft_c::instance().width(), display::tft_c::instance().height());
-    display::drawTextInCanvas(0
-        , display::tft_c::instance().height() / 2
-        , display::tft_c::instance().width()
-        , display::tft_c::instance().height() / 2
-        , "Please wait Democratically"
-        , ARYLIDE_YELLOW
-        , 3);
+    display::panel().fillRect(0, 0, display::panel().width(), display::panel().height(), INDIGO_DYE);
+    display::drawImage(m_background_image, 0, 0, display::panel().width(), display::panel().height());
+    m_damage.clear();
+    m_scene.clear();
+
+    gui::wf_element_t const text = {0
+        , static_cast<int16_t>(display::panel().height() / 2)
+        , display::panel().width()
+        , static_cast<int16_t>(display::panel().height() / 2)};
+    display::drawTextInCanvas(text.x, text.y, text.width, text.height, "Please wait Democratically", ARYLIDE_YELLOW, 3);
+    m_damage.add(text);
     m_prev_state = m_state;
 }
 
 void view_c::homeScreen()
 {
+    render_timing::scope_c timer(render_timing::stage_t::SCREEN_HOME);
+#if defined(DEBUG)
+    unsigned long const start_ms = millis();
+#endif
     m_state = view_state_t::HOME;
-    if (m_prev_state == view_state_t::LOADING)
-    {
-        // Clear only the text section
-        display::drawBmp("/bckgrnd.bmp"
-            , 0
-            , 0
-            , display::tft_c::instance().width()
-            , display::tft_c::instance().height()
-            , false
-            , display::tft_c::instance().height() / 2);
-    }
-    else if (m_prev_state == view_state_t::MAIN_MENU)
-    {
-        // Clear only up to the top of the menu buttons
-        display::drawBmp("/bckgrnd.bmp"
-            , 0
-            , 0
-            , display::tft_c::instance().width()
-            , display::tft_c::instance().height()
-            , false
-            , display::tft_c::instance().height() - DEFAULT_MENU_BUTTON_HEIGHT);
-    }
-    else
-    {
-        display::drawBmp("/bckgrnd.bmp", 0, 0, display::tft_c::instance().width(), display::tft_c::instance().height());
-    }
-    
+    _damageScreen();
     _deleteMenuButtons();
 
     //////////////////////////
@@ -147,18 +170,13 @@ void view_c::homeScreen()
         String macro_file_paths[num_active_macros_list];
         macro::macro_c macros[num_active_macros_list];
     
-        size_t count = m_presenter->handleLoadMacros(
+        m_presenter->handleLoadMacros(
             m_active_macros_list, num_active_macros_list, macro_names, macro_file_paths, macros);
 
         createHomeScreenMacroButtons(macros, macro_names, macro_file_paths);
         m_update_macros = false;
     }
 
-    for (int i = 0; i < MACRO_BTN_COUNT(m_active_macros); i++)
-    {
-        if (m_active_macros[i] == nullptr) continue;
-        m_active_macros[i]->draw();
-    }
     gui::wf_home_screen_t wf;
 
     m_menu_buttons[home_settings] = new gui::button_base_c(wf.menu_button.x
@@ -167,16 +185,34 @@ void view_c::homeScreen()
         , DEFAULT_MACRO_BUTTON_HEIGHT
         , "Settings");
     m_menu_buttons[home_settings]->imageFilePath("menu.bmp");
+    m_menu_buttons[home_settings]->transparent(display::iconTransparent("menu.bmp"));
     m_menu_buttons[home_settings]->drawCallback(handleDrawBmpButton, this);
     m_menu_buttons[home_settings]->callback(handleMainMenu, this);
-    m_menu_buttons[home_settings]->draw();
+
+    if (!_homeSnapshot())
+    {
+        for (size_t i = 0; i < MACRO_BTN_COUNT(m_active_macros); i++)
+        {
+            _cover(m_active_macros[i]);
+        }
+        _cover(m_menu_buttons[home_settings]);
+        _restoreDamage();
+
+        _drawScreen();
+    }
     m_prev_state = m_state;
+
+#if defined(DEBUG)
+    // Compare with and without "/icons/icons.pak" on the card
+    Serial.println("Home screen: " + String(millis() - start_ms) + " ms");
+#endif
 }
 
 void view_c::mainMenu()
 {
+    render_timing::scope_c timer(render_timing::stage_t::SCREEN_MENU);
     m_state = view_state_t::MAIN_MENU;
-    display::drawBmp("/bckgrnd.bmp", 0, 0, display::tft_c::instance().width(), display::tft_c::instance().height());
+    _damageScreen();
     _deleteMenuButtons();
     
     gui::wf_main_menu_t wf;
@@ -193,11 +229,14 @@ void view_c::mainMenu()
     
     m_menu_buttons[main_menu_load]->drawCallback(handleDrawButton, this);
     m_menu_buttons[main_menu_load]->callback(handleMacroSelect, this);
-    m_menu_buttons[main_menu_load]->draw();
-
     m_menu_buttons[main_menu_back]->drawCallback(handleDrawButton, this);
     m_menu_buttons[main_menu_back]->callback(handleHomeScreen, this);
-    m_menu_buttons[main_menu_back]->draw();
+
+    _cover(m_menu_buttons[main_menu_load]);
+    _cover(m_menu_buttons[main_menu_back]);
+    _restoreDamage();
+
+    _drawScreen();
     m_prev_state = m_state;
 }
 
@@ -205,22 +244,9 @@ void view_c::mainMenu()
 /// @details This screen allows the user to select a macro to place on the home screen
 void view_c::macroSelect()
 {
+    render_timing::scope_c timer(render_timing::stage_t::SCREEN_MACRO_SELECT);
     m_state = view_state_t::MACRO_SELECT;
-    if (m_prev_state == view_state_t::MAIN_MENU)
-    {
-        // Clear only up to the top of the menu buttons
-        display::drawBmp("/bckgrnd.bmp"
-            , 0
-            , 0
-            , display::tft_c::instance().width()
-            , display::tft_c::instance().height()
-            , false
-            , display::tft_c::instance().height() - DEFAULT_MENU_BUTTON_HEIGHT);
-    }
-    else
-    {
-        display::drawBmp("/bckgrnd.bmp", 0, 0, display::tft_c::instance().width(), display::tft_c::instance().height());
-    }
+    _damageScreen();
 
     if (m_prev_state == view_state_t::MACRO_PLACE) _deleteMacroPlacementOptions();
 
@@ -253,9 +279,13 @@ void view_c::macroSelect()
     // Get the macros to display
     uint16_t ids[MACRO_SELECT_OPTIONS];
     String names[MACRO_SELECT_OPTIONS];
+    String images[MACRO_SELECT_OPTIONS];
 
     uint16_t start_search_id = 0;
 
+    // Scrolling pages through the options rather than moving the rows on the panel. The ILI9341 can only scroll
+    // along its 320 pixel side, which is the screen's x axis in this orientation, so VSCRDEF/VSCRSADD can't shift
+    // a vertical list. Rows whose label doesn't change are left alone by m_scene.
     if (m_scroll > 0)
     {
         // scroll right/down
@@ -266,12 +296,15 @@ void view_c::macroSelect()
         // scroll left/up
         start_search_id = min_option - MACRO_SELECT_OPTIONS;
     }
-    size_t options = m_presenter->handleGetMacroOptions(MACRO_SELECT_OPTIONS, ids, names, start_search_id);
+    // The icon names are read from the macro file for the page, so only ask for them when they can be drawn
+    bool const thumbnails = display::thumbnailsAvailable();
+    size_t options = m_presenter->handleGetMacroOptions(
+        MACRO_SELECT_OPTIONS, ids, names, start_search_id, thumbnails ? images : nullptr);
     min_option = ids[0];
     max_option = ids[options - 1];
     
     // figure out what scrolling is needed
-    bool enable_scroll = options < num_macros; /// No need to scroll
+    bool enable_scroll = options < static_cast<size_t>(num_macros); /// No need to scroll
     bool enable_scroll_left = true;
     bool enable_scroll_right = true;
     
@@ -281,14 +314,14 @@ void view_c::macroSelect()
     {
         // if the min id is in the list, disable the scroll left button
         // if the max id is in the list, disable the scroll right button
-        for (int i = 0; i < options; i++)
+        for (size_t i = 0; i < options; i++)
         {
             if (ids[i] == min) enable_scroll_left = false;
             if (ids[i] == max) enable_scroll_right = false;
         }
     }
 
-    for (int i = 0; i < options; i++)
+    for (size_t i = 0; i < options; i++)
     {
         _generateButton(wf.macro_select_options[i]
             , m_macro_select_options
@@ -304,6 +337,7 @@ void view_c::macroSelect()
         m_macro_select_options[i]->setPressedColours(UCLA_BLUE, ANTI_FLASH_WHITE, ANTI_FLASH_WHITE);
         m_macro_select_options[i]->setDisabledColours(UCLA_BLUE, ANTI_FLASH_WHITE, ANTI_FLASH_WHITE);
         m_macro_select_options[i]->id(ids[i]);
+        if (thumbnails) m_macro_select_options[i]->imageFilePath(images[i]);
 
         // Persist the currently selected macro visually
         bool active = true;
@@ -321,22 +355,32 @@ void view_c::macroSelect()
     }
     
     size_t draw_ids[] = {macro_select_left, macro_select_right, macro_select_done_place};
-    _drawButton(m_macro_select_options, MACRO_SELECT_OPTIONS);
-    _drawButton(m_menu_buttons, draw_ids, 3);
+    for (size_t i = 0; i < BTN_COUNT(m_macro_select_options); i++)
+    {
+        _cover(m_macro_select_options[i]);
+    }
+    for (size_t i = 0; i < 3; i++)
+    {
+        _cover(m_menu_buttons[draw_ids[i]]);
+    }
+    _restoreDamage();
+
+    _drawScreen();
     m_prev_state = m_state;
 }
 
 void view_c::macroPlace()
 {
+    render_timing::scope_c timer(render_timing::stage_t::SCREEN_MACRO_PLACE);
     m_state = view_state_t::MACRO_PLACE;
-    display::drawBmp("/bckgrnd.bmp", 0, 0, display::tft_c::instance().width(), display::tft_c::instance().height());
+    _damageScreen();
 
     _deleteMenuButtons();
     _deleteMacroSelectOptions();
     gui::wf_home_screen_t wf;
 
     // create the placement button options
-    for (int i = 0; i < BTN_COUNT(m_macro_placement_options); i++)
+    for (size_t i = 0; i < BTN_COUNT(m_macro_placement_options); i++)
     {
         _generateButton(wf.macro_buttons[i]
             , m_macro_placement_options
@@ -368,17 +412,110 @@ void view_c::macroPlace()
         m_menu_buttons[macro_select_done_place]->active(false);
     }
     
-    _drawButton(m_macro_placement_options, MACRO_PLACE_OPTIONS);
-    m_menu_buttons[macro_select_done_place]->draw();
+    for (size_t i = 0; i < BTN_COUNT(m_macro_placement_options); i++)
+    {
+        _cover(m_macro_placement_options[i]);
+    }
+    _cover(m_menu_buttons[macro_select_done_place]);
+    _restoreDamage();
+
+    _drawScreen();
     m_prev_state = m_state;
 }
 
-void view_c::_drawButton(gui::button_base_c **button_array, size_t const count)
+void view_c::_drawScreen()
 {
-    for (size_t i = 0; i < count; i++)
+    // A new frame, or the rest of one abandoned for a touch. Buttons already on the display are skipped by m_scene.
+    m_frame_incomplete = false;
+    m_thumbnail_spent_us = 0;
+    m_thumbnails_deferred = false;
+
+    switch (m_state)
+    {
+    case view_state_t::HOME:
+        for (size_t i = 0; i < MACRO_BTN_COUNT(m_active_macros); i++)
+        {
+            _drawInterruptible(m_active_macros[i]);
+        }
+        _drawInterruptible(m_menu_buttons[home_settings]);
+        break;
+    case view_state_t::MAIN_MENU:
+        _drawInterruptible(m_menu_buttons[main_menu_load]);
+        _drawInterruptible(m_menu_buttons[main_menu_back]);
+        break;
+    case view_state_t::MACRO_SELECT:
+        for (size_t i = 0; i < BTN_COUNT(m_macro_select_options); i++)
+        {
+            _drawInterruptible(m_macro_select_options[i]);
+        }
+        _drawInterruptible(m_menu_buttons[macro_select_left]);
+        _drawInterruptible(m_menu_buttons[macro_select_right]);
+        _drawInterruptible(m_menu_buttons[macro_select_done_place]);
+        break;
+    case view_state_t::MACRO_PLACE:
+        for (size_t i = 0; i < BTN_COUNT(m_macro_placement_options); i++)
+        {
+            _drawInterruptible(m_macro_placement_options[i]);
+        }
+        _drawInterruptible(m_menu_buttons[macro_select_done_place]);
+        break;
+    default:
+        break;
+    }
+
+    // Come back for thumbnails left out for the budget, buttons drawn with theirs are skipped
+    if (m_thumbnails_deferred) m_frame_incomplete = true;
+
+#if defined(DEBUG)
+    // Time from the first touch of a burst to the frame the burst ended on
+    if (!m_frame_incomplete && (m_burst_start_ms != 0))
+    {
+        Serial.println("Touch to frame: " + String(millis() - m_burst_start_ms) + " ms, "
+            + String(m_frames_dropped) + " frames dropped");
+        m_burst_start_ms = 0;
+        m_frames_dropped = 0;
+    }
+#endif
+}
+
+void view_c::_drawInterruptible(gui::button_base_c *button)
+{
+    if ((button == nullptr) || m_frame_incomplete) return;
+
+    // A new press now makes the rest of the frame stale, leave it for the press to be handled first. The finger that
+    // started the frame is still down for a while, and touched() reports it again once the debounce time is up, so
+    // the screen has to be released before a press counts.
+    if (!m_touch_pending)
+    {
+        bool const pressed = touched(&m_pending_touch);
+        if (m_pending_touch.z <= MINPRESSURE) m_awaiting_release = false;
+        m_touch_pending = pressed && !m_awaiting_release;
+    }
+    if (m_touch_pending)
+    {
+        m_frame_incomplete = true;
+#if defined(DEBUG)
+        m_frames_dropped++;
+#endif
+        return;
+    }
+
+    button->draw();
+}
+
+bool view_c::_takeTouch(TSPoint *tp)
+{
+    if (m_touch_pending)
     {
-        if (button_array[i] != nullptr) button_array[i]->draw();
+        *tp = m_pending_touch;
+        m_touch_pending = false;
+        m_awaiting_release = true;
+        return true;
     }
+
+    bool const pressed = touched(tp);
+    m_awaiting_release = pressed || (m_awaiting_release && (tp->z > MINPRESSURE));
+    return pressed;
 }
 
 void view_c::_drawButton(gui::button_base_c **button_array, size_t const *idx, size_t const count)
@@ -397,37 +534,18 @@ void view_c::_generateButton(
     void * callback_ctx,
     drawButtonCallback draw_callback,
     void * draw_callback_ctx,
-    int const idx
+    size_t const idx
 )
 {
-    if (idx >= 0)
-    {
-        if (button_array[idx] != nullptr) delete button_array[idx]; // delete the old button
-
-        button_array[idx] = new gui::button_base_c(element.x
-            , element.y
-            , element.width
-            , element.height
-            , text);
-        button_array[idx]->callback(callback, callback_ctx);
-        button_array[idx]->drawCallback(draw_callback, draw_callback_ctx);
-        return;
-    }
-    
-    // Find the first available slot
-    for (size_t i = 0; i < BTN_COUNT(button_array); i++)
-    {
-        if (button_array[i] != nullptr) continue;
-
-        button_array[i] = new gui::button_base_c(element.x
-            , element.y
-            , element.width
-            , element.height
-            , text);
-        button_array[i]->callback(callback, callback_ctx);
-        button_array[i]->drawCallback(draw_callback, draw_callback_ctx);
-        break;
-    }
+    if (button_array[idx] != nullptr) delete button_array[idx]; // delete the old button
+
+    button_array[idx] = new gui::button_base_c(element.x
+        , element.y
+        , element.width
+        , element.height
+        , text);
+    button_array[idx]->callback(callback, callback_ctx);
+    button_array[idx]->drawCallback(draw_callback, draw_callback_ctx);
 }
 
 void view_c::createHomeScreenMacroButtons(macro::macro_c const *macros, String const *names, String const *file_paths)
@@ -454,6 +572,7 @@ void view_c::_createHomeScreenMacroButton(
     m_active_macros[idx]->width(wf.macro_buttons[idx].width);
     m_active_macros[idx]->height(wf.macro_buttons[idx].height);
     m_active_macros[idx]->drawCallback(handleDrawBmpButton, this);
+    m_active_macros[idx]->transparent(display::iconTransparent(*file_path));
     m_active_macros[idx]->id(m_active_macros_list[idx]); // assume this for debugging
 }
 
@@ -555,23 +674,235 @@ void view_c::_saveActiveMacros()
         int val = m_active_macros_list[i];
         EEPROM.update(i, val);
     }
+
+    // The snapshot shows the old macros, it is drawn again with the new ones on the way home
+    SD.remove(HOME_SNAPSHOT);
+}
+
+void view_c::_damage(gui::button_base_c const *button)
+{
+    if (button == nullptr) return;
+    m_damage.add({button->minX(), button->minY(), button->width(), button->height()});
+}
+
+void view_c::_damageScreen()
+{
+    // Menu buttons are replaced on every screen change, so any that exist are on the screen
+    for (size_t i = 0; i < BTN_COUNT(m_menu_buttons); i++)
+    {
+        _damage(m_menu_buttons[i]);
+    }
+
+    // The other buttons outlive their screen, only damage them if they were shown
+    switch (m_prev_state)
+    {
+    case view_state_t::HOME:
+        for (size_t i = 0; i < MACRO_BTN_COUNT(m_active_macros); i++)
+        {
+            _damage(m_active_macros[i]);
+        }
+        break;
+    case view_state_t::MACRO_SELECT:
+        for (size_t i = 0; i < BTN_COUNT(m_macro_select_options); i++)
+        {
+            _damage(m_macro_select_options[i]);
+        }
+        break;
+    case view_state_t::MACRO_PLACE:
+        for (size_t i = 0; i < BTN_COUNT(m_macro_placement_options); i++)
+        {
+            _damage(m_macro_placement_options[i]);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void view_c::_cover(gui::button_base_c const *button)
+{
+    // Buttons fill their whole rectangle, icons are expected to be the size of their button
+    if (button == nullptr) return;
+
+    // Transparent icons show what is behind them, so leave the damage under them to be restored
+    if (button->transparent()) return;
+    m_damage.cover({button->minX(), button->minY(), button->width(), button->height()});
+}
+
+void view_c::_restoreDamage()
+{
+#if defined(DEBUG)
+    size_t const rects = m_damage.count();
+    uint32_t const pixels = m_damage.flush(handleRestoreBackground, this);
+    Serial.println("Restored " + String(rects) + " regions, " + String(pixels * 2) + " bytes");
+
+    uint32_t hits, misses, cache_bytes;
+    display::backgroundCacheStats(&hits, &misses, &cache_bytes);
+    Serial.println("Background cache: " + String(hits) + " hits, " + String(misses) + " misses, "
+        + String(cache_bytes) + " of " + String(BG_CACHE_BYTES) + " bytes used, " + String(freeRam())
+        + " bytes free");
+#else
+    m_damage.flush(handleRestoreBackground, this);
+#endif
+}
+
+bool view_c::_homeSnapshot()
+{
+    // Nothing to gain when every button is already on the display, e.g. back from the main menu
+    bool all_shown = m_scene.shown(_bmpWidget(*m_menu_buttons[home_settings]));
+    for (size_t i = 0; all_shown && (i < MACRO_BTN_COUNT(m_active_macros)); i++)
+    {
+        if (m_active_macros[i] != nullptr) all_shown = m_scene.shown(_bmpWidget(*m_active_macros[i]));
+    }
+    if (all_shown) return false;
+
+    uint32_t const content_key = _homeContentKey();
+    if (display::drawSnapshot(HOME_SNAPSHOT, m_background_image, content_key))
+    {
+        // The whole screen is drawn, the buttons are left for _drawScreen to skip
+        m_damage.clear();
+        m_scene.clear();
+        for (size_t i = 0; i < MACRO_BTN_COUNT(m_active_macros); i++)
+        {
+            if (m_active_macros[i] != nullptr) m_scene.update(_bmpWidget(*m_active_macros[i]));
+        }
+        m_scene.update(_bmpWidget(*m_menu_buttons[home_settings]));
+        _drawScreen();
+        return true;
+    }
+
+    // No snapshot, so draw every pixel of the screen while saving one
+    if (!display::beginSnapshot(HOME_SNAPSHOT, m_background_image, content_key)) return false;
+
+    m_damage.clear();
+    m_scene.clear();
+    display::restoreBackground(m_background_image, 0, 0, display::panel().width(), display::panel().height());
+    _drawScreen();
+
+    // A frame left part drawn for a touch isn't worth keeping, the next full draw saves it
+    display::endSnapshot(!m_frame_incomplete);
+    return true;
+}
+
+uint32_t view_c::_homeContentKey() const
+{
+    // FNV-1a over the label and image hashes of every slot, an empty slot hashes as an empty label and image
+    uint32_t key = 2166136261UL;
+    for (size_t i = 0; i <= MACRO_BTN_COUNT(m_active_macros); i++)
+    {
+        gui::button_base_c const *button = (i < MACRO_BTN_COUNT(m_active_macros))
+            ? m_active_macros[i] : m_menu_buttons[home_settings];
+        uint32_t const hashes[2] = {
+            (button != nullptr) ? gui::scene_c::hash(button->name()) : 0,
+            (button != nullptr) ? gui::scene_c::hash(button->imageFilePath()) : 0};
+        for (uint8_t h = 0; h < 2; h++)
+        {
+            for (uint8_t b = 0; b < 4; b++)
+            {
+                key = (key ^ ((hashes[h] >> (b * 8)) & 0xFF)) * 16777619UL;
+            }
+        }
+    }
+    return key;
 }
 
 void view_c::_drawButton(gui::button_base_c const & button)
 {
-    display::drawButton(button.minX()
-    , button.minY()
-    , button.width()
-    , button.height()
-    , button.fillColour()
-    , button.textColour()
-    , button.borderColour()
-    , button.name());
+    bool const has_image = (button.imageFilePath().length() > 0);
+    gui::widget_t widget = {{button.minX(), button.minY(), button.width(), button.height()}
+        , static_cast<uint16_t>(button.fillColour())
+        , static_cast<uint16_t>(button.textColour())
+        , static_cast<uint16_t>(button.borderColour())
+        , gui::scene_c::hash(button.name())
+        , gui::scene_c::hash(button.imageFilePath())};
+
+    // Past the budget the button is drawn without its thumbnail, unless it is already shown with it. The thumbnail
+    // is part of the widget, so the button is drawn again with it once there is time.
+    bool thumbnail = has_image;
+    if (thumbnail && (m_thumbnail_spent_us >= THUMBNAIL_BUDGET_US) && !m_scene.shown(widget))
+    {
+        thumbnail = false;
+        widget.image_hash = 0;
+    }
+
+    // A row left without its thumbnail only needs the thumbnail, its empty slot is already drawn
+    gui::widget_t without_thumbnail = widget;
+    without_thumbnail.image_hash = 0;
+    bool const row_shown = thumbnail && m_scene.shown(without_thumbnail);
+    if (!m_scene.update(widget)) return;
+
+    if (!has_image)
+    {
+        display::drawButton(button.minX()
+        , button.minY()
+        , button.width()
+        , button.height()
+        , button.fillColour()
+        , button.textColour()
+        , button.borderColour()
+        , button.name()
+        , 0
+        , button.textLayout());
+        return;
+    }
+
+    // The slot and the label share the border column between them
+    int16_t constexpr slot = MACRO_SELECT_THUMBNAIL_SLOT;
+    if (!row_shown)
+    {
+        display::drawButton(button.minX()
+        , button.minY()
+        , slot
+        , button.height()
+        , button.fillColour()
+        , button.textColour()
+        , button.borderColour());
+        display::drawButton(button.minX() + slot - 1
+        , button.minY()
+        , button.width() - slot + 1
+        , button.height()
+        , button.fillColour()
+        , button.textColour()
+        , button.borderColour()
+        , button.name()
+        , 0
+        , button.textLayout());
+    }
+
+    if (!thumbnail)
+    {
+        m_thumbnails_deferred = true;
+        return;
+    }
+
+    unsigned long const start_us = micros();
+    display::drawThumbnail(button.imageFilePath()
+        , button.minX() + (slot - icon_pack::THUMBNAIL_SIZE) / 2
+        , button.minY() + (button.height() - icon_pack::THUMBNAIL_SIZE) / 2);
+    m_thumbnail_spent_us += micros() - start_us;
+}
+
+gui::widget_t view_c::_bmpWidget(gui::button_base_c const & button)
+{
+    return {{button.minX(), button.minY(), button.width(), button.height()}
+        , 0
+        , 0
+        , 0
+        , 0
+        , gui::scene_c::hash(button.imageFilePath())};
 }
 
 void view_c::_drawButtonBmp(gui::button_base_c const & button)
 {
-    display::drawBmp(
+    if (!m_scene.update(_bmpWidget(button))) return;
+
+    if (display::drawPackedIcon(
+        button.imageFilePath(), button.minX(), button.minY(), button.width(), button.height(), true))
+    {
+        return;
+    }
+
+    display::drawImage(
         "/icons/" + button.imageFilePath(), button.minX(), button.minY(), button.width(), button.height(), true);
 }
 
@@ -602,6 +933,10 @@ void view_c::_updateActiveMacros()
 
 void view_c::_handleTouch(TSPoint const &tp)
 {
+    bus_stats::reset();
+    m_thumbnail_spent_us = 0;
+    m_thumbnails_deferred = false;
+
     switch (m_state)
     {
     case view_state_t::HOME:
@@ -619,6 +954,27 @@ void view_c::_handleTouch(TSPoint const &tp)
     default:
         break;
     }
+
+    // Buttons redrawn by the touch handlers outside of _drawScreen may have left thumbnails out too
+    if (m_thumbnails_deferred) m_frame_incomplete = true;
+
+#if defined(DEBUG)
+    // Bus traffic saved by sending runs in images as a repeated colour, for the screen just drawn
+    uint32_t runs, saved_bytes;
+    display::takeRunStats(&runs, &saved_bytes);
+    if (runs > 0)
+    {
+        Serial.println("Blit runs: " + String(runs) + ", " + String(saved_bytes) + " bytes saved");
+    }
+    Serial.println("BMP address windows: " + String(display::takeBmpWindows()));
+
+    // Widgets left alone because the display already showed them, since start up
+    Serial.println("Widgets: " + String(m_scene.drawn()) + " drawn, " + String(m_scene.skipped()) + " skipped");
+#endif
+
+    // What the transition sent over the bus, with BUS_STATS defined
+    static char const *const SCREENS[] = {"none", "loading", "home", "main menu", "macro select", "macro place", "error"};
+    bus_stats::dump(SCREENS[m_state]);
 }
 
 bool view_c::_homeScreenTouchHandler(TSPoint const &tp)
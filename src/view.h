@@ -27,8 +27,10 @@
 #include "view_abstract.h"
 #include "button.h"
 #include "constants.h"
+#include "damage.h"
 #include "ILI9341_driver.h"
 #include "macro_button.h"
+#include "scene.h"
 #include "tft_touch.h"
 #include "wireframe.h"
 
@@ -69,6 +71,40 @@ private:
     uint8_t m_current_selected_placement;
     bool m_update_macros;
     int m_scroll;
+    String m_background_image;
+
+    /// @brief The composited home screen, drawn in one stream instead of the background and every icon. Deleted
+    /// by _saveActiveMacros and rebuilt the next time the home screen is drawn in full.
+    static constexpr char const *HOME_SNAPSHOT = "/home.565";
+
+    /// @brief Regions where widgets have been removed and the background needs redrawing
+    gui::damage_c m_damage;
+
+    /// @brief Widgets currently on the display, so unchanged ones aren't drawn again
+    gui::scene_c m_scene;
+
+    /// @brief A touch read while drawing a screen, handled before anything else is drawn
+    TSPoint m_pending_touch;
+    bool m_touch_pending;
+
+    /// @brief The last touch handled hasn't been released yet, it can't interrupt a frame until it is
+    bool m_awaiting_release;
+
+    /// @brief The screen was left part drawn for a touch, see _drawScreen
+    bool m_frame_incomplete;
+
+    /// @brief Most time spent drawing thumbnails in a frame. The first thumbnail is always drawn, so a page flip
+    /// costs at most this plus one thumbnail (about 3 ms from the card) on top of its rows. Thumbnails past the
+    /// budget are left out and drawn once the frame is otherwise done, unless a touch comes first.
+    static uint32_t constexpr THUMBNAIL_BUDGET_US = 20000;
+    uint32_t m_thumbnail_spent_us;
+    bool m_thumbnails_deferred;
+
+#if defined(DEBUG)
+    /// @brief When the first touch of a burst was read, 0 once its final frame is drawn
+    unsigned long m_burst_start_ms;
+    uint8_t m_frames_dropped;
+#endif
     
     /// @brief Buttons and their indexes
     static size_t constexpr home_settings = 0;
@@ -126,14 +162,27 @@ public:
     void macroPlace();
     //////////////////// ~Main Window Rendering /////////////////////
 
-    ///////////////////// Managing button creations /////////////////////
+    ///////////////////// Interruptible drawing /////////////////////
 private:
-    /// @brief Draw a set of buttons
-    /// @param button_array Array of buttons to draw
-    /// @param count Number of buttons to draw, starting from the beginning of the array
-    /// @note This function will draw the buttons in the order specified
-    void _drawButton(gui::button_base_c **button_array, size_t const count);
+    /// @brief Draw the buttons of the current screen, stopping early if the screen is touched
+    /// @details Each button is a chunk of the frame. A touch between chunks leaves the rest of the frame undrawn, the
+    /// touch is handled first and usually draws a newer screen. If it doesn't, the run loop calls this again to
+    /// finish the frame, buttons already drawn are skipped by m_scene.
+    void _drawScreen();
+
+    /// @brief Draw a button unless the frame has been interrupted, checking for a new press first
+    /// @details A finger held down from the last touch doesn't interrupt, the screen must be released in between
+    /// @param button The button, may be nullptr
+    void _drawInterruptible(gui::button_base_c *button);
+
+    /// @brief Get the next touch, one read while drawing comes first
+    /// @param tp The touch
+    /// @return bool: True if there was a touch
+    bool _takeTouch(TSPoint *tp);
+    //////////////////// ~Interruptible drawing /////////////////////
 
+    ///////////////////// Managing button creations /////////////////////
+private:
     /// @brief Draw a set of buttons
     /// @param button_array Array of buttons to draw
     /// @param idx List of button_array indices to draw
@@ -149,8 +198,7 @@ private:
     /// @param callback_ctx The context in which to invoke the action function
     /// @param draw_callback The function to draw the button
     /// @param draw_callback_ctx The context in which to invoke the draw function
-    /// @param idx (optional) Specify the index of the array in which to create the button
-    /// @note This function will create buttons for the macros in the first available slots
+    /// @param idx The index of the array in which to create the button, replacing the one there
     void _generateButton(
         gui::wf_element_t const &element, 
         gui::button_base_c **button_array, 
@@ -159,7 +207,7 @@ private:
         void * callback_ctx,
         drawButtonCallback draw_callback,
         void * draw_callback_ctx,
-        int const idx = -1
+        size_t const idx
     );
 
 public:
@@ -206,10 +254,50 @@ private:
     void _deleteMacroPlacementOptions();
 
     /// @brief Save the active macros
-    /// @details This is used to save the active macros list to persistent storage
+    /// @details This is used to save the active macros list to persistent storage. The home screen snapshot shows
+    /// the old list, so it is deleted.
     void _saveActiveMacros();
     //////////////////// ~Managing button creations /////////////////////
 
+    ///////////////////// Damage tracking /////////////////////
+private:
+    /// @brief Mark a button's area as needing the background redrawn
+    /// @param button The button, ignored if nullptr
+    void _damage(gui::button_base_c const *button);
+
+    /// @brief Mark every widget shown by the previous screen as needing the background redrawn
+    /// @details Called at the start of each screen, before its buttons are replaced
+    void _damageScreen();
+
+    /// @brief Tell the damage tracker a button is about to be drawn over its area
+    /// @param button The button, ignored if nullptr
+    void _cover(gui::button_base_c const *button);
+
+    /// @brief Redraw the background wherever it is damaged and not about to be covered
+    void _restoreDamage();
+
+    /// @brief Draw the home screen's buttons from HOME_SNAPSHOT, or draw the whole screen and save it there
+    /// @return bool: False if neither could be done, the damage is left to be restored as usual
+    /// @note Only used when some of the buttons aren't already shown, otherwise restoring the damage costs less
+    bool _homeSnapshot();
+
+    /// @brief Fingerprint what the home screen shows on top of the background, for HOME_SNAPSHOT
+    /// @return uint32_t: Hash of the label and image of every active macro and the settings button
+    uint32_t _homeContentKey() const;
+
+public:
+    /// @brief Handler for restoring a damaged region of the background
+    static void handleRestoreBackground(void *obj, gui::wf_element_t const &rect)
+    {
+        if (obj)
+        {
+            view_c *view = static_cast<view_c*>(obj);
+            display::restoreBackground(view->m_background_image, rect.x, rect.y, rect.width, rect.height);
+            view->m_scene.forget(rect);
+        }
+    }
+    //////////////////// ~Damage tracking /////////////////////
+
     ///////////////////// BUTTON CALLBACK HANDLERS /////////////////////
 public:
     /// @brief Handler for the main menu button
@@ -274,6 +362,7 @@ public:
 private:
     /// @brief Draw a button
     /// @param button The button to draw
+    /// @note A button with an image shows the icon's thumbnail in a slot on its left, within THUMBNAIL_BUDGET_US
     void _drawButton(gui::button_base_c const & button);
 
 
@@ -281,6 +370,11 @@ private:
     /// @param button The button to draw
     void _drawButtonBmp(gui::button_base_c const & button);
 
+    /// @brief Describe a bmp button for m_scene
+    /// @param button The button
+    /// @return gui::widget_t: The widget _drawButtonBmp draws
+    static gui::widget_t _bmpWidget(gui::button_base_c const & button);
+
 
     /// @brief Scroll up the macro select options
     void _scrollUp();
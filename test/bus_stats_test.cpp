@@ -0,0 +1,133 @@
+/*
+    bus_stats_test.cpp
+    Description: Checks what counting_bus_c counts, built with BUS_HEATMAP. Known primitives are sent to the mock
+    ILI9341 through tft_c::instance(), whose bus is wrapped, and the counts and heatmap tiles compared with what they
+    must have sent. A scene drawn on the device is then compared with the bus bytes panel_framebuffer_c counts for it.
+        bus_stats_test <sd_example>
+*/
+
+#include <cstdio>
+
+#include "ILI9341_driver.h"
+#include "panel_framebuffer.h"
+
+namespace
+{
+
+uint32_t failures = 0;
+
+void expect(char const *what, uint32_t actual, uint32_t expected)
+{
+    if (actual == expected) return;
+    printf("%s: %u, expected %u\n", what, actual, expected);
+    failures++;
+}
+
+/// @brief Check every tile of the heatmap
+/// @param expected Returns the pixels a tile should have had written
+template <typename F> void expectTiles(char const *what, F expected)
+{
+    for (uint8_t ty = 0; ty < bus_stats::TILES_Y; ty++)
+    {
+        for (uint8_t tx = 0; tx < bus_stats::TILES_X; tx++)
+        {
+            uint16_t const tile = bus_stats::bus()->tile(tx, ty);
+            if (tile == expected(tx, ty)) continue;
+            printf("%s: tile %u,%u has %u pixels, expected %u\n", what, tx, ty, tile, expected(tx, ty));
+            failures++;
+        }
+    }
+}
+
+/// @brief Draw the scene the framebuffer is compared on, no outlines as the library draws their corners twice
+void drawScene()
+{
+    display::drawImage("/bckgrnd.bmp", 0, 0, 320, 240);
+    display::drawImage("/icons/AM-23040.bmp", 10, 10, 80, 80);
+    display::drawImage("/icons/ANTI-041.bmp", 280, 200, 80, 80);
+    display::restoreBackground("/bckgrnd.bmp", 30, 40, 50, 30);
+    display::drawButton(120, 20, 100, 50, INDIGO_DYE, ANTI_FLASH_WHITE, ARYLIDE_YELLOW, "Counted");
+    display::drawTextInCanvas(0, 180, 320, 60, "Counted text", ARYLIDE_YELLOW, 2);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <sd_example>\n", argv[0]);
+        return 2;
+    }
+    mock::loadCard(argv[1], "bus_stats_sd");
+
+    Arduino_ILI9341 &tft = display::tft_c::instance();
+    bus_stats::counters_t const &counts = bus_stats::bus()->counters();
+
+    // A fill of two whole tiles: CASET and PASET with 4 bytes each, RAMWR, then one repeated colour
+    bus_stats::reset();
+    tft.fillRect(8, 16, 16, 8, 0x1234);
+    expect("fill commands", counts.commands, 3);
+    expect("fill data bytes", counts.data_bytes, 8 + 16 * 8 * 2);
+    expect("fill windows", counts.windows, 1);
+    expect("fill pixels", counts.pixels, 16 * 8);
+    expect("fill repeats", counts.repeats, 1);
+    expect("fill repeat pixels", counts.repeat_pixels, 16 * 8);
+    expectTiles("fill", [](uint8_t tx, uint8_t ty) { return ((ty == 2) && ((tx == 1) || (tx == 2))) ? 64 : 0; });
+
+    // A bitmap straddling four tiles, sent as bytes
+    uint16_t bitmap[8 * 8] = {};
+    bus_stats::reset();
+    tft.draw16bitBeRGBBitmap(4, 4, bitmap, 8, 8);
+    expect("bitmap windows", counts.windows, 1);
+    expect("bitmap pixels", counts.pixels, 64);
+    expect("bitmap repeats", counts.repeats, 0);
+    expectTiles("bitmap", [](uint8_t tx, uint8_t ty) { return ((tx < 2) && (ty < 2)) ? 16 : 0; });
+
+    // Single pixels, as the library draws text at size 1, counted from their data bytes
+    bus_stats::reset();
+    tft.startWrite();
+    tft.writePixel(319, 239, 0xFFFF);
+    tft.writePixel(0, 0, 0xFFFF);
+    tft.endWrite();
+    expect("pixel windows", counts.windows, 2);
+    expect("pixel pixels", counts.pixels, 2);
+    expectTiles("pixel", [](uint8_t tx, uint8_t ty) {
+        return (((tx == 0) && (ty == 0)) || ((tx == (bus_stats::TILES_X - 1)) && (ty == (bus_stats::TILES_Y - 1))))
+            ? 1 : 0;
+    });
+
+    // More pixels than the window holds wrap back to its start, as the panel does
+    bus_stats::reset();
+    tft.startWrite();
+    tft.writeAddrWindow(0, 0, 2, 2);
+    tft.writeRepeat(0, 10);
+    tft.endWrite();
+    expect("wrap pixels", counts.pixels, 10);
+    expectTiles("wrap", [](uint8_t tx, uint8_t ty) { return ((tx == 0) && (ty == 0)) ? 10 : 0; });
+
+    // A whole screen in one window is every pixel of every tile once
+    bus_stats::reset();
+    tft.fillScreen(0);
+    expectTiles("screen", [](uint8_t, uint8_t) { return 64; });
+
+    // The same scene on the device and on the framebuffer puts the same bytes on the bus. It is drawn once first
+    // to write the sidecars, so both read the same files.
+    drawScene();
+    bus_stats::reset();
+    drawScene();
+    bus_stats::counters_t const device = counts;
+
+    display::panel_framebuffer_c framebuffer;
+    display::usePanel(&framebuffer);
+    drawScene();
+    display::usePanel(nullptr);
+    expect("scene windows", device.windows, framebuffer.stats().windows);
+    expect("scene bus bytes", device.commands + device.data_bytes, framebuffer.stats().bus_bytes);
+    expect("scene repeats", device.repeats, framebuffer.stats().repeats + framebuffer.stats().fills);
+
+    printf("scene: %u commands, %u data bytes, %u windows, %u pixels, %u repeats\n",
+        device.commands, device.data_bytes, device.windows, device.pixels, device.repeats);
+    printf("%u failures\n", failures);
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+/*
+    Arduino.h
+    Description: The parts of the Arduino core the sketch uses, for building it on a host.
+    String is backed by std::string, time stands still at 0 so renders don't depend on how fast the host is, and
+    Serial output is dropped.
+*/
+
+#ifndef __MOCK_ARDUINO_H__
+#define __MOCK_ARDUINO_H__
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+
+typedef uint8_t byte;
+
+#define PROGMEM
+#define pgm_read_byte(address) (*reinterpret_cast<uint8_t const *>(address))
+#define pgm_read_word(address) (*reinterpret_cast<uint16_t const *>(address))
+
+#define A2 16
+#define A3 17
+#define A4 18
+#define INPUT 0
+#define OUTPUT 1
+#define LOW 0
+#define HIGH 1
+
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+inline unsigned long millis() { return 0; }
+inline unsigned long micros() { return 0; }
+inline void delay(unsigned long) {}
+inline void delayMicroseconds(unsigned int) {}
+
+class __FlashStringHelper;
+#define F(text) (reinterpret_cast<__FlashStringHelper const *>(text))
+
+class String
+{
+public:
+    String(char const *text = "") : m_text(text ? text : "") {}
+    String(__FlashStringHelper const *text) : m_text(reinterpret_cast<char const *>(text)) {}
+    String(std::string const &text) : m_text(text) {}
+    String(char c) : m_text(1, c) {}
+    String(int value) : m_text(std::to_string(value)) {}
+    String(unsigned int value) : m_text(std::to_string(value)) {}
+    String(long value) : m_text(std::to_string(value)) {}
+    String(unsigned long value) : m_text(std::to_string(value)) {}
+    String(float value, unsigned char = 2) : m_text(std::to_string(value)) {}
+
+    unsigned int length() const { return m_text.size(); }
+    char const *c_str() const { return m_text.c_str(); }
+    char const *begin() const { return m_text.c_str(); }
+    char const *end() const { return m_text.c_str() + m_text.size(); }
+    void reserve(unsigned int size) { m_text.reserve(size); }
+
+    char operator[](unsigned int i) const { return (i < m_text.size()) ? m_text[i] : 0; }
+    char &operator[](unsigned int i) { return m_text[i]; }
+    char charAt(unsigned int i) const { return (*this)[i]; }
+
+    String &operator+=(String const &other) { m_text += other.m_text; return *this; }
+    String &operator+=(char const *other) { m_text += other; return *this; }
+    String &operator+=(char other) { m_text += other; return *this; }
+    bool operator==(String const &other) const { return m_text == other.m_text; }
+    bool operator==(char const *other) const { return m_text == other; }
+    bool operator!=(String const &other) const { return m_text != other.m_text; }
+    bool operator!=(char const *other) const { return m_text != other; }
+    bool operator<(String const &other) const { return m_text < other.m_text; }
+
+    int indexOf(char c, unsigned int from = 0) const { return _found(m_text.find(c, from)); }
+    int indexOf(String const &text, unsigned int from = 0) const { return _found(m_text.find(text.m_text, from)); }
+    int lastIndexOf(char c) const { return _found(m_text.rfind(c)); }
+
+    String substring(unsigned int from) const { return substring(from, m_text.size()); }
+    String substring(unsigned int from, unsigned int to) const
+    {
+        if (from > to) std::swap(from, to);
+        if (from >= m_text.size()) return String();
+        return String(m_text.substr(from, to - from));
+    }
+
+    bool startsWith(String const &prefix) const { return m_text.rfind(prefix.m_text, 0) == 0; }
+    bool endsWith(String const &suffix) const
+    {
+        return (m_text.size() >= suffix.m_text.size()) &&
+               (m_text.compare(m_text.size() - suffix.m_text.size(), suffix.m_text.size(), suffix.m_text) == 0);
+    }
+    bool equalsIgnoreCase(String const &other) const
+    {
+        String a(*this), b(other);
+        a.toLowerCase();
+        b.toLowerCase();
+        return a == b;
+    }
+
+    long toInt() const { return atol(m_text.c_str()); }
+
+    void trim()
+    {
+        size_t const first = m_text.find_first_not_of(" \t\r\n");
+        if (first == std::string::npos)
+        {
+            m_text.clear();
+            return;
+        }
+        m_text = m_text.substr(first, m_text.find_last_not_of(" \t\r\n") - first + 1);
+    }
+
+    void toUpperCase() { for (char &c : m_text) c = toupper(static_cast<unsigned char>(c)); }
+    void toLowerCase() { for (char &c : m_text) c = tolower(static_cast<unsigned char>(c)); }
+    void remove(unsigned int index, unsigned int count = UINT_MAX) { if (index < m_text.size()) m_text.erase(index, count); }
+
+    void replace(String const &find, String const &with)
+    {
+        if (find.m_text.empty()) return;
+        for (size_t at = m_text.find(find.m_text); at != std::string::npos;
+             at = m_text.find(find.m_text, at + with.m_text.size()))
+        {
+            m_text.replace(at, find.m_text.size(), with.m_text);
+        }
+    }
+
+private:
+    std::string m_text;
+
+    static int _found(size_t const at) { return (at == std::string::npos) ? -1 : static_cast<int>(at); }
+};
+
+inline String operator+(String a, String const &b) { a += b; return a; }
+inline String operator+(String a, char const *b) { a += b; return a; }
+inline String operator+(char const *a, String const &b) { String r(a); r += b; return r; }
+inline String operator+(String a, char b) { a += b; return a; }
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(uint8_t const *buffer, size_t size)
+    {
+        for (size_t i = 0; i < size; i++) write(buffer[i]);
+        return size;
+    }
+    size_t write(char const *text) { return write(reinterpret_cast<uint8_t const *>(text), strlen(text)); }
+    size_t write(char const *text, size_t size) { return write(reinterpret_cast<uint8_t const *>(text), size); }
+
+    size_t print(String const &text) { return write(text.c_str()); }
+    size_t print(char const *text) { return write(text); }
+    size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+    size_t print(int value, int = 10) { return print(String(value)); }
+    size_t print(unsigned int value, int = 10) { return print(String(value)); }
+    size_t print(long value, int = 10) { return print(String(value)); }
+    size_t print(unsigned long value, int = 10) { return print(String(value)); }
+    size_t print(double value, int = 2) { return print(String(static_cast<float>(value))); }
+
+    template <typename T> size_t println(T const &value) { return print(value) + println(); }
+    template <typename T> size_t println(T const &value, int format) { return print(value, format) + println(); }
+    size_t println() { return write("\r\n"); }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long) {}
+    operator bool() { return true; }
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+template <typename T> T min(T a, T b) { return (a < b) ? a : b; }
+template <typename T> T max(T a, T b) { return (a > b) ? a : b; }
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Deterministic, the lowest value allowed
+inline long random(long low, long) { return low; }
+inline long random(long) { return 0; }
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+#endif // __MOCK_ARDUINO_H__
@@ -0,0 +1,395 @@
+/*
+    Arduino_GFX_Library.h
+    Description: The parts of Arduino_GFX the sketch uses, for building it on a host.
+    Drawing calls are turned into the commands and data the library would put on the bus: CASET and PASET set the
+    address window and RAMWR writes pixels into it. Arduino_UNOPAR8 decodes them into mock::display, so whatever a
+    bus wrapper (see bus_stats.h) counts on its way through is also what ends up on the mock display.
+    The library's glcdfont table isn't copied here. Its place is taken by made up glyphs of the same size, so text
+    lands where it would but doesn't look the same. Goldens check where text is drawn and in what colour, not the
+    pixels of its glyphs.
+*/
+
+#ifndef __MOCK_ARDUINO_GFX_LIBRARY_H__
+#define __MOCK_ARDUINO_GFX_LIBRARY_H__
+
+#include <Arduino.h>
+
+#define GFX_NOT_DEFINED -1
+
+namespace mock
+{
+
+int16_t constexpr DISPLAY_WIDTH = 320;
+int16_t constexpr DISPLAY_HEIGHT = 240;
+
+/// @brief What the mock ILI9341 shows, in native order
+extern uint16_t display[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+/// @brief Made up 5x7 glyphs in the layout of the library's glcdfont, a byte per column and bit 0 at the top
+struct font_t
+{
+    uint8_t bytes[256 * 5];
+
+    constexpr font_t() : bytes()
+    {
+        for (uint16_t c = 33; c < 256; c++)
+        {
+            for (uint8_t col = 0; col < 5; col++)
+            {
+                bytes[c * 5 + col] = static_cast<uint8_t>(((c * 2654435761u) >> (col * 5)) & 0x7F);
+            }
+        }
+    }
+};
+
+constexpr font_t FONT;
+
+} // namespace mock
+
+static uint8_t const *const font = mock::FONT.bytes;
+
+class Arduino_DataBus
+{
+public:
+    virtual ~Arduino_DataBus() {}
+
+    virtual bool begin(int32_t speed = GFX_NOT_DEFINED, int8_t dataMode = GFX_NOT_DEFINED) = 0;
+    virtual void beginWrite() = 0;
+    virtual void endWrite() = 0;
+    virtual void writeCommand(uint8_t) = 0;
+    virtual void writeCommand16(uint16_t) = 0;
+    virtual void writeCommandBytes(uint8_t *data, uint32_t len) = 0;
+    virtual void write(uint8_t) = 0;
+    virtual void write16(uint16_t) = 0;
+    virtual void writeRepeat(uint16_t p, uint32_t len) = 0;
+    virtual void writePixels(uint16_t *data, uint32_t len) = 0;
+
+    virtual void writeC8D8(uint8_t c, uint8_t d)
+    {
+        writeCommand(c);
+        write(d);
+    }
+
+    virtual void writeC16D16(uint16_t c, uint16_t d)
+    {
+        writeCommand16(c);
+        write16(d);
+    }
+
+    virtual void writeC8D16(uint8_t c, uint16_t d)
+    {
+        writeCommand(c);
+        write16(d);
+    }
+
+    virtual void writeC8D16D16(uint8_t c, uint16_t d1, uint16_t d2)
+    {
+        writeCommand(c);
+        write16(d1);
+        write16(d2);
+    }
+
+    virtual void writeBytes(uint8_t *data, uint32_t len)
+    {
+        for (uint32_t i = 0; i < len; i++) write(data[i]);
+    }
+
+    virtual void writeIndexedPixels(uint8_t *data, uint16_t *idx, uint32_t len)
+    {
+        for (uint32_t i = 0; i < len; i++) write16(idx[data[i]]);
+    }
+
+    virtual void writeIndexedPixelsDouble(uint8_t *data, uint16_t *idx, uint32_t len)
+    {
+        for (uint32_t i = 0; i < len; i++)
+        {
+            write16(idx[data[i]]);
+            write16(idx[data[i]]);
+        }
+    }
+};
+
+/// @brief The shield's 8-bit parallel bus, decoding what is sent into mock::display
+class Arduino_UNOPAR8 : public Arduino_DataBus
+{
+public:
+    Arduino_UNOPAR8() : m_command(0), m_params(0), m_high(-1), m_x0(0), m_x1(0), m_y0(0), m_y1(0), m_x(0), m_y(0) {}
+
+    bool begin(int32_t = GFX_NOT_DEFINED, int8_t = GFX_NOT_DEFINED) override { return true; }
+    void beginWrite() override {}
+    void endWrite() override {}
+
+    void writeCommand(uint8_t c) override
+    {
+        m_command = c;
+        m_params = 0;
+        m_high = -1;
+        if (c == RAMWR)
+        {
+            m_x = m_x0;
+            m_y = m_y0;
+        }
+    }
+
+    void writeCommand16(uint16_t c) override { writeCommand(c & 0xFF); }
+
+    void writeCommandBytes(uint8_t *data, uint32_t len) override
+    {
+        for (uint32_t i = 0; i < len; i++) writeCommand(data[i]);
+    }
+
+    void write(uint8_t d) override
+    {
+        if ((m_command == CASET) || (m_command == PASET))
+        {
+            if (m_params < 4)
+            {
+                uint16_t *value = (m_command == CASET) ? ((m_params < 2) ? &m_x0 : &m_x1)
+                                                       : ((m_params < 2) ? &m_y0 : &m_y1);
+                *value = ((m_params % 2) == 0) ? (static_cast<uint16_t>(d) << 8) : (*value | d);
+            }
+            m_params++;
+        }
+        else if (m_command == RAMWR)
+        {
+            if (m_high < 0)
+            {
+                m_high = d;
+                return;
+            }
+            _pixel((static_cast<uint16_t>(m_high) << 8) | d);
+            m_high = -1;
+        }
+    }
+
+    void write16(uint16_t d) override
+    {
+        write(d >> 8);
+        write(d & 0xFF);
+    }
+
+    void writeRepeat(uint16_t p, uint32_t len) override
+    {
+        while (len-- > 0) write16(p);
+    }
+
+    void writePixels(uint16_t *data, uint32_t len) override
+    {
+        for (uint32_t i = 0; i < len; i++) write16(data[i]);
+    }
+
+private:
+    static uint8_t constexpr CASET = 0x2A;
+    static uint8_t constexpr PASET = 0x2B;
+    static uint8_t constexpr RAMWR = 0x2C;
+
+    uint8_t m_command;
+    uint8_t m_params;
+    int16_t m_high; ///< First byte of a pixel, -1 if none
+    uint16_t m_x0, m_x1, m_y0, m_y1;
+    uint16_t m_x, m_y;
+
+    /// @brief Put the next pixel of the window, the panel wraps back to the start once the window is full
+    void _pixel(uint16_t const colour)
+    {
+        if ((m_x < mock::DISPLAY_WIDTH) && (m_y < mock::DISPLAY_HEIGHT)) mock::display[m_y][m_x] = colour;
+        if (++m_x > m_x1)
+        {
+            m_x = m_x0;
+            if (++m_y > m_y1) m_y = m_y0;
+        }
+    }
+};
+
+class Arduino_GFX : public Print
+{
+public:
+    Arduino_GFX(int16_t w, int16_t h)
+    : _width(w)
+    , _height(h)
+    , _cursor_x(0)
+    , _cursor_y(0)
+    , _text_colour(0xFFFF)
+    , _text_bg(0xFFFF)
+    , _text_size(1)
+    , _wrap(true)
+    {
+    }
+
+    virtual bool begin(int32_t speed = GFX_NOT_DEFINED) = 0;
+    virtual void startWrite() = 0;
+    virtual void endWrite() = 0;
+    virtual void writePixel(int16_t x, int16_t y, uint16_t colour) = 0;
+    virtual void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) = 0;
+
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour)
+    {
+        startWrite();
+        writeFillRect(x, y, w, h, colour);
+        endWrite();
+    }
+
+    void fillScreen(uint16_t colour) { fillRect(0, 0, _width, _height, colour); }
+
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour)
+    {
+        startWrite();
+        writeFillRect(x, y, w, 1, colour);
+        writeFillRect(x, y + h - 1, w, 1, colour);
+        writeFillRect(x, y, 1, h, colour);
+        writeFillRect(x + w - 1, y, 1, h, colour);
+        endWrite();
+    }
+
+    void setCursor(int16_t x, int16_t y)
+    {
+        _cursor_x = x;
+        _cursor_y = y;
+    }
+
+    void setTextColor(uint16_t c) { _text_colour = _text_bg = c; }
+
+    void setTextColor(uint16_t c, uint16_t bg)
+    {
+        _text_colour = c;
+        _text_bg = bg;
+    }
+
+    void setTextSize(uint8_t s) { _text_size = (s > 0) ? s : 1; }
+    void setTextWrap(bool w) { _wrap = w; }
+
+    size_t write(uint8_t c) override
+    {
+        if (c == '\n')
+        {
+            _cursor_x = 0;
+            _cursor_y += _text_size * 8;
+            return 1;
+        }
+        if (c == '\r') return 1;
+
+        if (_wrap && ((_cursor_x + _text_size * 6) > _width))
+        {
+            _cursor_x = 0;
+            _cursor_y += _text_size * 8;
+        }
+        _drawChar(_cursor_x, _cursor_y, c);
+        _cursor_x += _text_size * 6;
+        return 1;
+    }
+    using Print::write;
+
+protected:
+    int16_t _width, _height;
+    int16_t _cursor_x, _cursor_y;
+    uint16_t _text_colour, _text_bg;
+    uint8_t _text_size;
+    bool _wrap;
+
+    void _drawChar(int16_t x, int16_t y, uint8_t c)
+    {
+        if (c >= 176) c++; // the library's default, not quite CP437, mapping
+        startWrite();
+        for (uint8_t col = 0; col < 5; col++)
+        {
+            uint8_t line = font[c * 5 + col];
+            for (uint8_t row = 0; row < 8; row++, line >>= 1)
+            {
+                if (!(line & 1)) continue;
+                if (_text_size == 1) writePixel(x + col, y + row, _text_colour);
+                else writeFillRect(x + col * _text_size, y + row * _text_size, _text_size, _text_size, _text_colour);
+            }
+        }
+        endWrite();
+    }
+};
+
+class Arduino_TFT : public Arduino_GFX
+{
+public:
+    Arduino_TFT(Arduino_DataBus *bus, int8_t, uint8_t, bool, int16_t w, int16_t h) : Arduino_GFX(w, h), _bus(bus) {}
+
+    bool begin(int32_t speed = GFX_NOT_DEFINED) override { return _bus->begin(speed); }
+    void startWrite() override { _bus->beginWrite(); }
+    void endWrite() override { _bus->endWrite(); }
+
+    virtual void writeAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) = 0;
+
+    void writePixel(int16_t x, int16_t y, uint16_t colour) override
+    {
+        if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height)) return;
+        writeAddrWindow(x, y, 1, 1);
+        _bus->write16(colour);
+    }
+
+    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) override
+    {
+        if (!_clip(&x, &y, &w, &h)) return;
+        writeAddrWindow(x, y, w, h);
+        _bus->writeRepeat(colour, static_cast<uint32_t>(w) * h);
+    }
+
+    void writeRepeat(uint16_t colour, uint32_t len) { _bus->writeRepeat(colour, len); }
+    void writePixels(uint16_t *data, uint32_t len) { _bus->writePixels(data, len); }
+    void writeBytes(uint8_t *data, uint32_t len) { _bus->writeBytes(data, len); }
+
+    void draw16bitBeRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h)
+    {
+        int16_t cx = x, cy = y, cw = w, ch = h;
+        if (!_clip(&cx, &cy, &cw, &ch)) return;
+
+        startWrite();
+        writeAddrWindow(cx, cy, cw, ch);
+        for (int16_t row = cy; row < (cy + ch); row++)
+        {
+            _bus->writeBytes(reinterpret_cast<uint8_t *>(&bitmap[(row - y) * w + (cx - x)]), cw * 2);
+        }
+        endWrite();
+    }
+
+protected:
+    Arduino_DataBus *_bus;
+
+    bool _clip(int16_t *x, int16_t *y, int16_t *w, int16_t *h) const
+    {
+        if (*x < 0)
+        {
+            *w += *x;
+            *x = 0;
+        }
+        if (*y < 0)
+        {
+            *h += *y;
+            *y = 0;
+        }
+        if ((*x + *w) > _width) *w = _width - *x;
+        if ((*y + *h) > _height) *h = _height - *y;
+        return (*w > 0) && (*h > 0);
+    }
+};
+
+class Arduino_ILI9341 : public Arduino_TFT
+{
+public:
+    Arduino_ILI9341(Arduino_DataBus *bus, int8_t rst = GFX_NOT_DEFINED, uint8_t r = 0, bool ips = false)
+    : Arduino_TFT(bus, rst, r, ips, mock::DISPLAY_WIDTH, mock::DISPLAY_HEIGHT)
+    {
+    }
+
+    void writeAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) override
+    {
+        _bus->writeC8D16D16(CASET, x, x + w - 1);
+        _bus->writeC8D16D16(PASET, y, y + h - 1);
+        _bus->writeCommand(RAMWR);
+    }
+
+private:
+    static uint8_t constexpr CASET = 0x2A;
+    static uint8_t constexpr PASET = 0x2B;
+    static uint8_t constexpr RAMWR = 0x2C;
+};
+
+#endif // __MOCK_ARDUINO_GFX_LIBRARY_H__
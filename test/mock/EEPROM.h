@@ -0,0 +1,42 @@
+/*
+    EEPROM.h
+    Description: EEPROM kept in RAM, for building the sketch on a host. Tests set the bytes the sketch reads back.
+*/
+
+#ifndef __MOCK_EEPROM_H__
+#define __MOCK_EEPROM_H__
+
+#include <Arduino.h>
+
+class EEPROMClass
+{
+public:
+    static size_t constexpr SIZE = 1024;
+
+    EEPROMClass() { memset(m_bytes, 0, sizeof(m_bytes)); }
+
+    uint8_t read(int address) const { return m_bytes[address]; }
+    void write(int address, uint8_t value) { m_bytes[address] = value; }
+    void update(int address, uint8_t value) { m_bytes[address] = value; }
+
+    template <typename T> T &get(int address, T &value) const
+    {
+        memcpy(&value, &m_bytes[address], sizeof(T));
+        return value;
+    }
+
+    template <typename T> T const &put(int address, T const &value)
+    {
+        memcpy(&m_bytes[address], &value, sizeof(T));
+        return value;
+    }
+
+    size_t length() const { return SIZE; }
+
+private:
+    uint8_t m_bytes[SIZE + sizeof(long long)]; ///< Room for a get() of the last address
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // __MOCK_EEPROM_H__
@@ -0,0 +1,163 @@
+/*
+    SD.h
+    Description: The SD library on top of a directory of the host, for building the sketch on a host.
+    Paths are relative to mock::sd_root. Like SdFat, a file can't be seeked past its end, and FILE_WRITE appends.
+    Opens, bytes read and seeks are counted in mock::sd_stats.
+*/
+
+#ifndef __MOCK_SD_H__
+#define __MOCK_SD_H__
+
+#include <Arduino.h>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+
+#define O_READ 0x01
+#define O_WRITE 0x02
+#define O_RDWR (O_READ | O_WRITE)
+#define O_APPEND 0x04
+#define O_CREAT 0x10
+#define O_TRUNC 0x40
+#define FILE_READ O_READ
+#define FILE_WRITE (O_READ | O_WRITE | O_CREAT | O_APPEND)
+
+namespace mock
+{
+
+/// @brief Directory the card's root is in
+extern std::string sd_root;
+
+struct sd_stats_t
+{
+    uint32_t opens;
+    uint32_t bytes_read;
+    uint32_t seeks;
+};
+
+extern sd_stats_t sd_stats;
+
+/// @brief Get the host path of a path on the card
+inline std::string sdPath(char const *path)
+{
+    return sd_root + ((path[0] == '/') ? "" : "/") + path;
+}
+
+/// @brief Use a fresh copy of a directory as the card, the sketch writes sidecars and snapshots to it
+/// @param source The directory to copy, e.g. sd_example
+/// @param card Where to put the copy, replacing whatever is there
+inline void loadCard(std::string const &source, std::string const &card)
+{
+    std::filesystem::remove_all(card);
+    std::filesystem::copy(source, card, std::filesystem::copy_options::recursive);
+    sd_root = card;
+}
+
+} // namespace mock
+
+class File : public Stream
+{
+public:
+    File() : m_append(false) {}
+    File(FILE *file, bool append) : m_file(file, [](FILE *f) { fclose(f); }), m_append(append) {}
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(uint8_t const *data, size_t size) override
+    {
+        if (!m_file) return 0;
+        if (m_append) fseek(m_file.get(), 0, SEEK_END);
+        return fwrite(data, 1, size, m_file.get());
+    }
+    using Print::write;
+
+    int read() override
+    {
+        uint8_t b;
+        return (read(&b, 1) == 1) ? b : -1;
+    }
+
+    int read(void *buffer, uint16_t size)
+    {
+        if (!m_file) return -1;
+        int const count = fread(buffer, 1, size, m_file.get());
+        if (count > 0) mock::sd_stats.bytes_read += count;
+        return count;
+    }
+
+    int peek() override
+    {
+        int const c = fgetc(m_file.get());
+        if (c != EOF) ungetc(c, m_file.get());
+        return c;
+    }
+
+    int available() override { return size() - position(); }
+    void flush() { fflush(m_file.get()); }
+
+    bool seek(uint32_t position)
+    {
+        mock::sd_stats.seeks++;
+        if (!m_file || (position > size())) return false;
+        return fseek(m_file.get(), position, SEEK_SET) == 0;
+    }
+
+    uint32_t position() { return ftell(m_file.get()); }
+
+    uint32_t size()
+    {
+        long const position = ftell(m_file.get());
+        fseek(m_file.get(), 0, SEEK_END);
+        long const end = ftell(m_file.get());
+        fseek(m_file.get(), position, SEEK_SET);
+        return end;
+    }
+
+    void close() { m_file.reset(); }
+    operator bool() const { return static_cast<bool>(m_file); }
+
+private:
+    std::shared_ptr<FILE> m_file;
+    bool m_append;
+};
+
+class SDClass
+{
+public:
+    bool begin(uint8_t = 10) { return true; }
+
+    File open(char const *path, uint8_t mode = FILE_READ)
+    {
+        std::string const host_path = mock::sdPath(path);
+        FILE *file = nullptr;
+        if (!(mode & O_WRITE))
+        {
+            file = fopen(host_path.c_str(), "rb");
+        }
+        else
+        {
+            if (!(mode & O_TRUNC)) file = fopen(host_path.c_str(), "r+b");
+            if ((file == nullptr) && (mode & O_CREAT)) file = fopen(host_path.c_str(), "w+b");
+        }
+        if (file == nullptr) return File();
+
+        mock::sd_stats.opens++;
+        return File(file, (mode & O_APPEND) != 0);
+    }
+
+    File open(String const &path, uint8_t mode = FILE_READ) { return open(path.c_str(), mode); }
+
+    bool exists(char const *path)
+    {
+        FILE *file = fopen(mock::sdPath(path).c_str(), "rb");
+        if (file) fclose(file);
+        return file != nullptr;
+    }
+
+    bool exists(String const &path) { return exists(path.c_str()); }
+    bool remove(char const *path) { return ::remove(mock::sdPath(path).c_str()) == 0; }
+    bool remove(String const &path) { return remove(path.c_str()); }
+};
+
+extern SDClass SD;
+
+#endif // __MOCK_SD_H__
@@ -0,0 +1,31 @@
+/*
+    SimpleVector.h
+    Description: The SimpleVector calls hashtable.h makes, on top of std::vector, for building the sketch on a host.
+*/
+
+#ifndef __MOCK_SIMPLE_VECTOR_H__
+#define __MOCK_SIMPLE_VECTOR_H__
+
+#include <vector>
+
+template <typename T>
+class SimpleVector
+{
+public:
+    void put(T const &value) { m_values.push_back(value); }
+    void push_back(T const &value) { m_values.push_back(value); }
+    size_t size() const { return m_values.size(); }
+
+    T &operator[](size_t i) { return m_values[i]; }
+    T const &operator[](size_t i) const { return m_values[i]; }
+
+    typename std::vector<T>::iterator begin() { return m_values.begin(); }
+    typename std::vector<T>::iterator end() { return m_values.end(); }
+    typename std::vector<T>::const_iterator begin() const { return m_values.begin(); }
+    typename std::vector<T>::const_iterator end() const { return m_values.end(); }
+
+private:
+    std::vector<T> m_values;
+};
+
+#endif // __MOCK_SIMPLE_VECTOR_H__
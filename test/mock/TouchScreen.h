@@ -0,0 +1,28 @@
+/*
+    TouchScreen.h
+    Description: A touch screen that is never touched, for building the sketch on a host.
+*/
+
+#ifndef __MOCK_TOUCHSCREEN_H__
+#define __MOCK_TOUCHSCREEN_H__
+
+#include <Arduino.h>
+
+class TSPoint
+{
+public:
+    TSPoint() : x(0), y(0), z(0) {}
+    TSPoint(int16_t x_, int16_t y_, int16_t z_) : x(x_), y(y_), z(z_) {}
+
+    int16_t x, y, z;
+};
+
+class TouchScreen
+{
+public:
+    TouchScreen(uint8_t, uint8_t, uint8_t, uint8_t, uint16_t) {}
+
+    TSPoint getPoint() { return TSPoint(); }
+};
+
+#endif // __MOCK_TOUCHSCREEN_H__
@@ -0,0 +1,24 @@
+/*
+    mock.cpp
+    Description: The globals the mocked Arduino libraries declare.
+*/
+
+#include <Arduino.h>
+#include <Arduino_GFX_Library.h>
+#include <EEPROM.h>
+#include <Keyboard.h>
+#include <SD.h>
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+Keyboard_ Keyboard;
+SDClass SD;
+
+namespace mock
+{
+
+std::string sd_root = ".";
+sd_stats_t sd_stats = {};
+uint16_t display[DISPLAY_HEIGHT][DISPLAY_WIDTH] = {};
+
+} // namespace mock
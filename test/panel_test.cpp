@@ -0,0 +1,96 @@
+/*
+    panel_test.cpp
+    Description: Draws the same images, buttons and text on the mock ILI9341 and on a panel_framebuffer_c, and checks
+    the two frames match pixel for pixel. The render test trusts the framebuffer to show what the display would.
+    Then checks when a snapshot recorded through panel_snapshot_c is kept and when it is stale.
+        panel_test <sd_example>
+*/
+
+#include <cstdio>
+
+#include "ILI9341_driver.h"
+#include "panel_framebuffer.h"
+
+namespace
+{
+
+display::panel_framebuffer_c framebuffer;
+
+/// @brief Draw through every path of the driver that ends at the panel
+void drawAll()
+{
+    display::drawImage("/bckgrnd.bmp", 0, 0, 320, 240);
+    display::drawImage("/icons/AM-23040.bmp", 10, 10, 80, 80, true);
+    display::drawImage("/icons/ANTI-041.bmp", 280, 200, 80, 80); // clipped by the screen's edges
+    display::drawImage("/icons/ANTI-042.bmp", 100, 100, 80, 80, false, 30); // bottom rows only
+    display::restoreBackground("/bckgrnd.bmp", 30, 40, 50, 30);
+    display::drawButton(120, 20, 100, 50, INDIGO_DYE, ANTI_FLASH_WHITE, ARYLIDE_YELLOW, "Line buffer button");
+    display::drawButton(-20, 150, 100, 50, UCLA_BLUE, RICH_BLACK, ANTI_FLASH_WHITE, "Library button");
+    display::drawTextInCanvas(0, 180, 320, 60, "Text through the panel", ARYLIDE_YELLOW, 2);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <sd_example>\n", argv[0]);
+        return 2;
+    }
+    mock::loadCard(argv[1], "panel_sd");
+
+    // The first draw writes the background's sidecar, the second reads it
+    display::usePanel(nullptr);
+    drawAll();
+
+    framebuffer.clear(0);
+    display::usePanel(&framebuffer);
+    drawAll();
+    display::usePanel(nullptr);
+
+    uint32_t diff = 0;
+    for (int16_t y = 0; y < mock::DISPLAY_HEIGHT; y++)
+    {
+        for (int16_t x = 0; x < mock::DISPLAY_WIDTH; x++)
+        {
+            if (mock::display[y][x] != framebuffer.pixel(x, y)) diff++;
+        }
+    }
+    printf("device and framebuffer: %u pixels differ\n", diff);
+    uint32_t failures = (diff == 0) ? 0 : 1;
+
+    // A snapshot is kept for the keys it was recorded with. It isn't kept when something was drawn past the end of
+    // the file so far, or a message was drawn around the panel.
+    char const *const snapshot = "/snap.565";
+    char const *const background = "/bckgrnd.bmp";
+    display::usePanel(&framebuffer);
+    bool const begun = display::beginSnapshot(snapshot, background, 1);
+    drawAll();
+    display::endSnapshot(true);
+    uint32_t const size = File(SD.open(snapshot)).size();
+    bool const kept = display::drawSnapshot(snapshot, background, 1);
+    bool const stale = !display::drawSnapshot(snapshot, background, 2);
+
+    display::beginSnapshot(snapshot, background, 1);
+    display::drawButton(120, 200, 100, 30, INDIGO_DYE, ANTI_FLASH_WHITE, ARYLIDE_YELLOW, "Before the background");
+    drawAll();
+    display::endSnapshot(true);
+    bool const out_of_order = !display::drawSnapshot(snapshot, background, 1) && !SD.exists(snapshot);
+
+    display::beginSnapshot(snapshot, background, 1);
+    drawAll();
+    display::displayMessage("Message");
+    display::endSnapshot(true);
+    bool const abandoned = !display::drawSnapshot(snapshot, background, 1) && !SD.exists(snapshot);
+    display::usePanel(nullptr);
+
+    uint32_t const full_size = sizeof(sidecar::header_t) + 320UL * 240 * 2;
+    printf("snapshot: %s, %u of %u bytes, %s, %s, %s, %s\n", begun ? "begun" : "NOT begun", size, full_size,
+        kept ? "kept" : "NOT kept", stale ? "stale for another key" : "NOT stale for another key",
+        out_of_order ? "dropped for a draw past the end" : "NOT dropped for a draw past the end",
+        abandoned ? "abandoned for a message" : "NOT abandoned for a message");
+    if (!begun || (size != full_size) || !kept || !stale || !out_of_order || !abandoned) failures++;
+
+    return (failures == 0) ? 0 : 1;
+}
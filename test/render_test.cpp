@@ -0,0 +1,121 @@
+/*
+    render_test.cpp
+    Description: Renders each screen of the view into a panel_framebuffer_c, from a copy of sd_example, and compares
+    it with the golden PPM committed for it in test/golden. The bytes each screen put on the bus are printed, so a
+    rendering change can be measured as well as checked.
+        render_test <sd_example> <golden> [--update]
+    With --update the goldens are written instead of compared, for a change that is meant to alter what is shown.
+    Text is drawn with the mock's made up font, so the goldens prove where labels go and their colours, not that
+    their glyphs match the library's.
+*/
+
+#include <cstdio>
+
+#include "panel_framebuffer.h"
+#include "model.h"
+#include "presenter.h"
+#include "view.h"
+
+namespace
+{
+
+/// @brief The macros placed on the home screen, as the EEPROM holds them
+uint8_t constexpr ACTIVE_MACROS[MACRO_PLACE_OPTIONS] = {0, 1, 2, 3, 4, 5, 6};
+
+display::panel_framebuffer_c framebuffer;
+
+/// @brief Check the frame of a screen against its golden, or write the golden
+/// @return bool: True if the frame matched or the golden was written
+bool check(char const *state, std::string const &golden_dir, bool update)
+{
+    std::string const golden = golden_dir + "/" + state + ".ppm";
+    display::panel_stats_t const &stats = framebuffer.stats();
+    printf("%-14s bus %7u bytes, %4u windows", state, stats.bus_bytes, stats.windows);
+
+    if (update)
+    {
+        bool const written = framebuffer.writePPM(golden.c_str());
+        printf(written ? ", golden written\n" : ", golden NOT written\n");
+        return written;
+    }
+
+    uint32_t const diff = framebuffer.diffPPM(golden.c_str());
+    if (diff == UINT32_MAX)
+    {
+        printf(", no golden at %s\n", golden.c_str());
+        return false;
+    }
+    printf(", %u pixels differ\n", diff);
+    if (diff != 0)
+    {
+        framebuffer.writePPM((std::string(state) + ".ppm").c_str());
+    }
+    return diff == 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <sd_example> <golden> [--update]\n", argv[0]);
+        return 2;
+    }
+    std::string const golden_dir = argv[2];
+    bool const update = (argc > 3) && (std::string(argv[3]) == "--update");
+
+    mock::loadCard(argv[1], "render_sd");
+
+    for (size_t i = 0; i < MACRO_PLACE_OPTIONS; i++)
+    {
+        EEPROM.write(i, ACTIVE_MACROS[i]);
+    }
+
+    display::usePanel(&framebuffer);
+    model::model_c model;
+    view::view_c view;
+    presenter::presenter_c presenter(&model, &view);
+
+    bool ok = true;
+
+    framebuffer.resetStats();
+    view.loadScreen();
+    ok &= check("loading", golden_dir, update);
+
+    // As view_c::run loads the macros placed on the home screen
+    uint16_t ids[MACRO_PLACE_OPTIONS];
+    String names[MACRO_PLACE_OPTIONS];
+    String file_paths[MACRO_PLACE_OPTIONS];
+    macro::macro_c macros[MACRO_PLACE_OPTIONS];
+    for (size_t i = 0; i < MACRO_PLACE_OPTIONS; i++)
+    {
+        ids[i] = ACTIVE_MACROS[i];
+    }
+    presenter.handleLoadMacros(ids, MACRO_PLACE_OPTIONS, names, file_paths, macros);
+    view.createHomeScreenMacroButtons(macros, names, file_paths);
+
+    framebuffer.resetStats();
+    view.homeScreen();
+    ok &= check("home", golden_dir, update);
+
+    framebuffer.resetStats();
+    view.mainMenu();
+    ok &= check("main_menu", golden_dir, update);
+
+    framebuffer.resetStats();
+    view.macroSelect();
+    ok &= check("macro_select", golden_dir, update);
+
+    framebuffer.resetStats();
+    view.macroPlace();
+    ok &= check("macro_place", golden_dir, update);
+
+    // Back home, drawn from the snapshot the first visit saved
+    framebuffer.resetStats();
+    view.homeScreen();
+    ok &= check("home_snapshot", golden_dir, update);
+
+    display::usePanel(nullptr);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+/*
+    rgb565_test.cpp
+    Description: Checks the line conversions in rgb565.h against fromRGB, one pixel at a time.
+    Every 24-bit colour is converted in each of the four lanes of the four pixel kernel, in both byte orders, and
+    lines of every length up to a few kernels check the tail and that nothing is written past the end. The time both
+    take over a screen wide line is printed, from the host's clock, so only a rough guide to the board.
+*/
+
+#include <chrono>
+#include <cstdio>
+
+#include "rgb565.h"
+
+namespace
+{
+
+/// @brief Pixels converted at a time, plus up to 3 in front
+uint32_t constexpr RUN = 4096;
+uint32_t constexpr MAX_LINE = RUN + 3;
+
+uint32_t failures = 0;
+
+/// @brief The conversion one pixel at a time, the reference the kernels must match
+void scalarBGR24(uint8_t const *src, uint16_t *dst, uint32_t count, bool const wire_order)
+{
+    for (; count > 0; count--)
+    {
+        uint16_t const colour = rgb565::fromRGB(src[2], src[1], src[0]);
+        *dst++ = wire_order ? rgb565::swap(colour) : colour;
+        src += 3;
+    }
+}
+
+/// @brief Convert a line both ways and count the pixels that differ, and any written past the end
+void compare(char const *what, uint8_t const *src, uint32_t count, uint32_t stride, bool const wire_order)
+{
+    static uint16_t expected[MAX_LINE];
+    static uint16_t actual[MAX_LINE + 1]; // and a guard
+    uint16_t constexpr GUARD = 0xA5A5;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint8_t const *p = src + i * stride;
+        uint16_t const colour = rgb565::fromRGB(p[2], p[1], p[0]);
+        expected[i] = wire_order ? rgb565::swap(colour) : colour;
+    }
+    actual[count] = GUARD;
+
+    if (stride == 3) rgb565::fromBGR24(src, actual, count, wire_order);
+    else rgb565::fromBGRA32(src, actual, count, wire_order);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (actual[i] == expected[i]) continue;
+        if (failures++ < 10)
+        {
+            printf("%s: pixel %u of %u is %04X, expected %04X\n", what, i, count, actual[i], expected[i]);
+        }
+    }
+    if (actual[count] != GUARD)
+    {
+        printf("%s: wrote past the end of %u pixels\n", what, count);
+        failures++;
+    }
+}
+
+/// @brief Time a conversion of a line, many times over
+/// @return double: Nanoseconds per line
+template <typename F> double timeLine(F convert)
+{
+    int constexpr LINES = 200000;
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LINES; i++) convert();
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / LINES;
+}
+
+} // namespace
+
+int main()
+{
+    // Every colour, in runs with 0 to 3 pixels in front so each colour goes through each lane
+    static uint8_t line[MAX_LINE * 4];
+    for (uint8_t lane = 0; lane < 4; lane++)
+    {
+        for (uint32_t first = 0; first < (1UL << 24); first += RUN)
+        {
+            for (uint32_t i = 0; i < (RUN + lane); i++)
+            {
+                uint32_t const colour = (first + i - lane) & 0xFFFFFF;
+                line[i * 3 + 0] = colour & 0xFF;
+                line[i * 3 + 1] = (colour >> 8) & 0xFF;
+                line[i * 3 + 2] = colour >> 16;
+            }
+            compare("24-bit", line, RUN + lane, 3, false);
+            compare("24-bit wire order", line, RUN + lane, 3, true);
+        }
+    }
+    printf("all 24-bit colours in all four lanes: %u failures\n", failures);
+
+    // Every length up to four kernels, for the tail, from bytes that aren't a pattern
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < sizeof(line); i++)
+    {
+        seed = seed * 1664525UL + 1013904223UL;
+        line[i] = seed >> 24;
+    }
+    for (uint32_t count = 0; count <= 17; count++)
+    {
+        compare("24-bit tail", line, count, 3, false);
+        compare("24-bit tail wire order", line, count, 3, true);
+        compare("32-bit", line, count, 4, false);
+        compare("32-bit wire order", line, count, 4, true);
+    }
+    printf("lines of 0 to 17 pixels: %u failures\n", failures);
+
+    // A screen wide line, as drawn for a background
+    static uint16_t out[320];
+    double const scalar_ns = timeLine([&] { scalarBGR24(line, out, 320, true); });
+    double const kernel_ns = timeLine([&] { rgb565::fromBGR24(line, out, 320, true); });
+    printf("320 pixel line: %.0f ns one pixel at a time, %.0f ns four at a time\n", scalar_ns, kernel_ns);
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,433 @@
+#!/usr/bin/env python3
+"""
+bmp_tool.py
+Description: Prepares images for the macro pad's SD card. Run on a PC, not the device.
+
+Usage:
+    python3 bmp_tool.py topdown sd_example/bckgrnd.bmp sd_example/icons/*.bmp
+    python3 bmp_tool.py topdown -o out_dir sd_example/icons/*.bmp
+
+    python3 bmp_tool.py index sd_example/icons/*.bmp
+    python3 bmp_tool.py index --colours 16 sd_example/icons/*.bmp
+    python3 bmp_tool.py rle sd_example/bckgrnd.bmp
+    python3 bmp_tool.py pack -o sd_example/icons/icons.pak sd_example/icons/*.bmp
+    python3 bmp_tool.py thumbs -o sd_example/icons/thumbs.pak sd_example/icons/*.bmp
+
+Commands:
+    topdown     Rewrite bitmaps with their lines stored top-down (negative height), so the device reads each image
+                as one forward stream from the card.
+    index       Rewrite 24-bit bitmaps as 8, 4 or 1-bit indexed colour (top-down). Colours are compared as the
+                display shows them (RGB565), so this is lossless on the device as long as the image fits in
+                --colours. Images with more colours are reduced to the most used ones.
+    rle         Write a run-length encoded copy of each bitmap next to it (".rle", see src/rle.h). Images with
+                large flat areas become much smaller and draw faster.
+    pack        Build an icon pack (see src/icon_pack.h) holding every icon pre-converted, each stored raw or
+                run-length encoded, whichever is smaller. The device keeps the pack open and draws icons from it
+                without opening a file per icon. Icons missing from the pack are still read from /icons/.
+    thumbs      Build a thumbnail pack, the same layout as an icon pack holding each icon shrunk to --size pixels
+                square (24 by default, see src/icon_pack.h) with a box filter. The macro select list shows them
+                next to each macro's name.
+"""
+
+import argparse
+import array
+import os
+import struct
+import sys
+
+BI_RGB = 0  # uncompressed
+
+
+class Bitmap:
+    """An uncompressed BMP held with its rows in top-down order"""
+
+    def __init__(self, width, height, bpp, rows, palette=None):
+        self.width = width
+        self.height = height
+        self.bpp = bpp
+        self.rows = rows  # list of bytes, one per row, top row first, padding removed
+        self.palette = palette or []  # list of (b, g, r) tuples for bpp <= 8
+
+    @staticmethod
+    def line_bytes(width, bpp):
+        """Bytes per stored line, BMP lines are padded to 32 bits"""
+        return ((bpp * width + 31) // 32) * 4
+
+
+def read_bmp(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    if data[0:2] != b'BM':
+        raise ValueError('%s: not a BMP file' % path)
+
+    data_offset = struct.unpack_from('<I', data, 10)[0]
+    header_size = struct.unpack_from('<I', data, 14)[0]
+    width, height = struct.unpack_from('<ii', data, 18)
+    bpp = struct.unpack_from('<H', data, 28)[0]
+    compression = struct.unpack_from('<I', data, 30)[0]
+    colours_used = struct.unpack_from('<I', data, 46)[0]
+
+    if compression != BI_RGB:
+        raise ValueError('%s: compressed bitmaps are not supported' % path)
+    if bpp not in (1, 4, 8, 24):
+        raise ValueError('%s: %d bits per pixel is not supported' % (path, bpp))
+
+    palette = []
+    if bpp <= 8:
+        count = colours_used or (1 << bpp)
+        base = 14 + header_size
+        palette = [struct.unpack_from('<BBB', data, base + 4 * i) for i in range(count)]
+
+    top_down = height < 0
+    height = abs(height)
+    stride = Bitmap.line_bytes(width, bpp)
+    used = (bpp * width + 7) // 8
+    lines = [data[data_offset + i * stride: data_offset + i * stride + used] for i in range(height)]
+    if not top_down:
+        lines.reverse()
+
+    return Bitmap(width, height, bpp, lines, palette)
+
+
+def write_bmp(path, bitmap, top_down=True):
+    stride = Bitmap.line_bytes(bitmap.width, bitmap.bpp)
+    padding = b'\0' * (stride - (bitmap.bpp * bitmap.width + 7) // 8)
+    palette = b''.join(struct.pack('<BBBB', b, g, r, 0) for (b, g, r) in bitmap.palette)
+    data_offset = 14 + 40 + len(palette)
+    lines = bitmap.rows if top_down else list(reversed(bitmap.rows))
+    pixels = b''.join(line + padding for line in lines)
+
+    file_header = struct.pack('<2sIHHI', b'BM', data_offset + len(pixels), 0, 0, data_offset)
+    info_header = struct.pack(
+        '<IiiHHIIiiII',
+        40,
+        bitmap.width,
+        -bitmap.height if top_down else bitmap.height,
+        1,
+        bitmap.bpp,
+        BI_RGB,
+        len(pixels),
+        2835,  # 72 DPI
+        2835,
+        len(bitmap.palette),
+        0)
+
+    with open(path, 'wb') as f:
+        f.write(file_header + info_header + palette + pixels)
+
+
+def output_path(path, out_dir, extension=None):
+    name = os.path.basename(path)
+    if extension:
+        name = os.path.splitext(name)[0] + extension
+    directory = out_dir if out_dir else os.path.dirname(path)
+    return os.path.join(directory, name)
+
+
+def rgb565(b, g, r):
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def nearest(colour, palette):
+    """Index of the palette entry closest to an RGB565 colour"""
+    r, g, b = colour >> 11, (colour >> 5) & 0x3F, colour & 0x1F
+
+    def distance(entry):
+        return (r - (entry >> 11)) ** 2 + (g - ((entry >> 5) & 0x3F)) ** 2 + (b - (entry & 0x1F)) ** 2
+
+    return min(range(len(palette)), key=lambda i: distance(palette[i]))
+
+
+def to_indexed(bitmap, max_colours):
+    """Convert a 24-bit bitmap to the smallest indexed depth that holds max_colours"""
+    pixels = []
+    counts = {}
+    for row in bitmap.rows:
+        line = [rgb565(row[i], row[i + 1], row[i + 2]) for i in range(0, len(row), 3)]
+        pixels.append(line)
+        for colour in line:
+            counts[colour] = counts.get(colour, 0) + 1
+
+    palette = sorted(counts, key=lambda c: -counts[c])[:max_colours]
+    lookup = {colour: i for i, colour in enumerate(palette)}
+    for colour in counts:
+        if colour not in lookup:
+            lookup[colour] = nearest(colour, palette)
+
+    bpp = 1 if len(palette) <= 2 else 4 if len(palette) <= 16 else 8
+    rows = []
+    for line in pixels:
+        indices = [lookup[colour] for colour in line]
+        if bpp == 8:
+            rows.append(bytes(indices))
+        else:
+            per_byte = 8 // bpp
+            indices += [0] * (-len(indices) % per_byte)
+            packed = bytearray()
+            for i in range(0, len(indices), per_byte):
+                value = 0
+                for index in indices[i:i + per_byte]:
+                    value = (value << bpp) | index
+                packed.append(value)
+            rows.append(bytes(packed))
+
+    # Expand back to 8 bits per channel, the device truncates them to the same RGB565 colour
+    entries = [((c & 0x1F) << 3, ((c >> 5) & 0x3F) << 2, (c >> 11) << 3) for c in palette]
+    return Bitmap(bitmap.width, bitmap.height, bpp, rows, entries), len(counts)
+
+
+def pixels565(bitmap):
+    """The bitmap's pixels as rows of RGB565 colours, top row first"""
+    if bitmap.bpp == 24:
+        return [[rgb565(row[i], row[i + 1], row[i + 2]) for i in range(0, 3 * bitmap.width, 3)]
+                for row in bitmap.rows]
+
+    palette = [rgb565(b, g, r) for (b, g, r) in bitmap.palette]
+    per_byte = 8 // bitmap.bpp
+    mask = (1 << bitmap.bpp) - 1
+    rows = []
+    for row in bitmap.rows:
+        line = []
+        for x in range(bitmap.width):
+            shift = (per_byte - 1 - x % per_byte) * bitmap.bpp
+            line.append(palette[(row[x // per_byte] >> shift) & mask])
+        rows.append(line)
+    return rows
+
+
+RLE_MAGIC = b'RLE5'
+RLE_VERSION = 2
+RLE_RUN_FLAG = 0x80
+RLE_MAX_PACKET = 128
+RLE_MIN_RUN = 3  # a run of two costs as much as two literals
+
+
+def rle_row(line):
+    """Encode one row as packets, see src/rle.h"""
+    out = bytearray()
+    literal = []
+
+    def flush():
+        if literal:
+            out.append(len(literal) - 1)
+            out.extend(array_bytes(literal))
+            del literal[:]
+
+    i = 0
+    while i < len(line):
+        run = 1
+        while i + run < len(line) and line[i + run] == line[i] and run < RLE_MAX_PACKET:
+            run += 1
+
+        if run >= RLE_MIN_RUN:
+            flush()
+            out.append(RLE_RUN_FLAG | (run - 1))
+            out.extend(struct.pack('>H', line[i]))
+            i += run
+        else:
+            literal.append(line[i])
+            i += 1
+            if len(literal) == RLE_MAX_PACKET:
+                flush()
+
+    flush()
+    return bytes(out)
+
+
+def array_bytes(colours):
+    """Colours most significant byte first, the order the display is sent them"""
+    values = array.array('H', colours)
+    if sys.byteorder != 'big':
+        values.byteswap()
+    return values.tobytes()
+
+
+def rle_image(rows, width):
+    """A complete RLE image, header included. Row offsets are relative to the start of the image"""
+    height = len(rows)
+    header = struct.pack('<4sBBHHH', RLE_MAGIC, RLE_VERSION, 0, width, height, 0)
+    encoded = [rle_row(line) for line in rows]
+
+    offsets = []
+    position = len(header) + 4 * height
+    for packets in encoded:
+        offsets.append(position)
+        position += len(packets)
+
+    return header + struct.pack('<%dI' % height, *offsets) + b''.join(encoded)
+
+
+def write_rle(path, rows, width):
+    data = rle_image(rows, width)
+    with open(path, 'wb') as f:
+        f.write(data)
+    return len(data)
+
+
+PACK_MAGIC = b'IPK5'
+PACK_VERSION = 2
+PACK_NAME_LENGTH = 12
+PACK_FORMAT_RAW565 = 0
+PACK_FORMAT_RLE = 1
+PACK_HEADER = '<4sBBH'
+PACK_ENTRY = '<12sIHHBB2x'
+PACK_FLAG_TRANSPARENT = 0x01
+COLOUR_KEY = 0xF81F  # magenta, see src/rgb565.h
+
+
+def box_filter(rows, size):
+    """Shrink rows of RGB565 colours to size x size, each pixel the average of the box of pixels it covers.
+    Pixels of the colour key are left out of the average, a box that is mostly key stays key."""
+    height = len(rows)
+    width = len(rows[0])
+    out = []
+    for ty in range(size):
+        y0, y1 = ty * height // size, max((ty + 1) * height // size, ty * height // size + 1)
+        line = []
+        for tx in range(size):
+            x0, x1 = tx * width // size, max((tx + 1) * width // size, tx * width // size + 1)
+            box = [rows[y][x] for y in range(y0, y1) for x in range(x0, x1)]
+            colours = [c for c in box if c != COLOUR_KEY]
+            if 2 * len(colours) <= len(box):
+                line.append(COLOUR_KEY)
+                continue
+
+            # Average each channel at 8 bits, then round back to RGB565
+            r = sum(((c >> 11) & 0x1F) * 255 // 31 for c in colours) // len(colours)
+            g = sum(((c >> 5) & 0x3F) * 255 // 63 for c in colours) // len(colours)
+            b = sum((c & 0x1F) * 255 // 31 for c in colours) // len(colours)
+            colour = rgb565(b, g, r)
+            line.append(colour if colour != COLOUR_KEY else colour ^ 0x0001)
+        out.append(line)
+    return out
+
+
+def write_pack(path, sources, shrink=None):
+    """Write an icon pack (see src/icon_pack.h) from a list of bitmap paths, each shrunk to shrink x shrink pixels
+    if given"""
+    icons = {}
+    for source in sources:
+        name = os.path.basename(source).upper()
+        if len(name) > PACK_NAME_LENGTH:
+            raise ValueError('%s: names are limited to 8.3 characters' % source)
+        if name in icons:
+            raise ValueError('%s: more than one icon called %s' % (source, name))
+
+        rows = pixels565(read_bmp(source))
+        if shrink:
+            rows = box_filter(rows, shrink)
+        width, height = len(rows[0]), len(rows)
+        raw = b''.join(array_bytes(line) for line in rows)
+        rle = rle_image(rows, width)
+        flags = PACK_FLAG_TRANSPARENT if any(COLOUR_KEY in line for line in rows) else 0
+        if len(rle) < len(raw):
+            icons[name] = (width, height, PACK_FORMAT_RLE, flags, rle)
+        else:
+            icons[name] = (width, height, PACK_FORMAT_RAW565, flags, raw)
+
+    # The device binary searches the directory, so it must be sorted the same way it compares (byte order)
+    names = sorted(icons, key=lambda n: n.encode('ascii'))
+    offset = struct.calcsize(PACK_HEADER) + len(names) * struct.calcsize(PACK_ENTRY)
+
+    directory = []
+    data = []
+    for name in names:
+        width, height, fmt, flags, pixels = icons[name]
+        directory.append(struct.pack(PACK_ENTRY, name.encode('ascii'), offset, width, height, fmt, flags))
+        data.append(pixels)
+        offset += len(pixels)
+
+    with open(path, 'wb') as f:
+        f.write(struct.pack(PACK_HEADER, PACK_MAGIC, PACK_VERSION, 0, len(names)))
+        f.write(b''.join(directory))
+        f.write(b''.join(data))
+    return [(name, icons[name][2], icons[name][3]) for name in names], offset
+
+
+def cmd_topdown(args):
+    for path in args.files:
+        bitmap = read_bmp(path)
+        out = output_path(path, args.out_dir)
+        write_bmp(out, bitmap, top_down=True)
+        print('%s -> %s (%dx%d, top-down)' % (path, out, bitmap.width, bitmap.height))
+
+
+def cmd_index(args):
+    for path in args.files:
+        bitmap = read_bmp(path)
+        if bitmap.bpp != 24:
+            print('%s: skipped, already %d bits per pixel' % (path, bitmap.bpp))
+            continue
+        indexed, colours = to_indexed(bitmap, args.colours)
+        out = output_path(path, args.out_dir)
+        write_bmp(out, indexed, top_down=True)
+        note = '' if colours <= args.colours else ', reduced from %d colours' % colours
+        print('%s -> %s (%d-bit, %d colours%s)' % (path, out, indexed.bpp, len(indexed.palette), note))
+
+
+def cmd_rle(args):
+    for path in args.files:
+        bitmap = read_bmp(path)
+        out = output_path(path, args.out_dir, '.rle')
+        size = write_rle(out, pixels565(bitmap), bitmap.width)
+        raw = bitmap.width * bitmap.height * 2
+        print('%s -> %s (%d bytes, %d%% of raw RGB565)' % (path, out, size, 100 * size // raw))
+
+
+def cmd_pack(args):
+    icons, size = write_pack(args.out, args.files)
+    rle = sum(1 for _, fmt, _ in icons if fmt == PACK_FORMAT_RLE)
+    transparent = sum(1 for _, _, flags in icons if flags & PACK_FLAG_TRANSPARENT)
+    print('%s: %d icons (%d run-length encoded, %d transparent), %d bytes'
+          % (args.out, len(icons), rle, transparent, size))
+
+
+def cmd_thumbs(args):
+    icons, size = write_pack(args.out, args.files, args.size)
+    transparent = sum(1 for _, _, flags in icons if flags & PACK_FLAG_TRANSPARENT)
+    print('%s: %d thumbnails of %dx%d (%d transparent), %d bytes'
+          % (args.out, len(icons), args.size, args.size, transparent, size))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Prepare images for the macro pad SD card')
+    commands = parser.add_subparsers(dest='command')
+    commands.required = True
+
+    topdown = commands.add_parser('topdown', help='rewrite bitmaps with top-down lines')
+    topdown.add_argument('-o', '--out-dir', help='write here instead of overwriting the input files')
+    topdown.add_argument('files', nargs='+')
+    topdown.set_defaults(func=cmd_topdown)
+
+    index = commands.add_parser('index', help='rewrite 24-bit bitmaps as indexed colour')
+    index.add_argument('-o', '--out-dir', help='write here instead of overwriting the input files')
+    index.add_argument('-c', '--colours', type=int, default=256, choices=(2, 16, 256),
+                       help='maximum palette size (default: 256)')
+    index.add_argument('files', nargs='+')
+    index.set_defaults(func=cmd_index)
+
+    rle = commands.add_parser('rle', help='write run-length encoded copies of bitmaps')
+    rle.add_argument('-o', '--out-dir', help='write here instead of next to the input files')
+    rle.add_argument('files', nargs='+')
+    rle.set_defaults(func=cmd_rle)
+
+    pack = commands.add_parser('pack', help='build an icon pack from bitmaps')
+    pack.add_argument('-o', '--out', default='icons.pak', help='the pack to write (default: icons.pak)')
+    pack.add_argument('files', nargs='+')
+    pack.set_defaults(func=cmd_pack)
+
+    thumbs = commands.add_parser('thumbs', help='build a thumbnail pack from bitmaps')
+    thumbs.add_argument('-o', '--out', default='thumbs.pak', help='the pack to write (default: thumbs.pak)')
+    thumbs.add_argument('-s', '--size', type=int, default=24, help='width and height in pixels (default: 24)')
+    thumbs.add_argument('files', nargs='+')
+    thumbs.set_defaults(func=cmd_thumbs)
+
+    args = parser.parse_args()
+    if getattr(args, 'out_dir', None) and not os.path.isdir(args.out_dir):
+        os.makedirs(args.out_dir)
+    args.func(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())